@@ -37,9 +37,12 @@
 	#include	<../source/fftaudio_cuda.h>
 #else
 	#include	<../source/fftaudio_fftw.h>
+	#include	<../source/fftaudio_convolver.h>
+	#include	<../source/fftaudio_gccphat.h>
 #endif
 
 #include	<fftaudio_status.h>
+#include	<../source/fftaudio_stream.h>
 #include	<fftaudio_windows.h>
 
 #endif // FFTA__EXTERN__H__
@@ -54,7 +54,14 @@ typedef enum ffta_status_enum {
 	FFTA_TRANSPORT_CREATE_FAILED,
 
 	// Failed to create a fft plan needed by underlying api
-	FFTA_PLAN_CREATE_FAILED
+	FFTA_PLAN_CREATE_FAILED,
+
+	// The requested feature isn't supported by the underlying api
+	FFTA_UNSUPPORTED,
+
+	// Failed to lock memory or set real-time scheduling, the api status
+	// holds the errno value
+	FFTA_REALTIME_SETUP_FAILED
 } fftaStatusCode;
 
 
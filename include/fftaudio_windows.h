@@ -21,22 +21,23 @@
 //
 // Window functions, for use in constructors
 //		The Rectangle window is equivalent to using no window function
+//		Each function is available for float and double ('T') tables
 //
 class fftaWindow
 {
 public:
-	static void Rectangle(int frame_size, float &sum_output, float *values);
-	static void Triangluar(int frame_size, float &sum_output, float *values);
-	static void Bartlett(int frame_size, float &sum_output, float *values);
-	static void Sine(int frame_size, float &sum_output, float *values);
-	static void Hann(int frame_size, float &sum_output, float *values);
-	static void Hamming(int frame_size, float &sum_output, float *values);
-	static void Welch(int frame_size, float &sum_output, float *values);
-	static void Blackman(int frame_size, float &sum_output, float *values);
-	static void Nuttall(int frame_size, float &sum_output, float *values);
-	static void BlackmanNuttall(int frame_size, float &sum_output, float *values);
-	static void BlackmanHarris(int frame_size, float &sum_output, float *values);
-	static void FlatTop(int frame_size, float &sum_output, float *values);
+	template<typename T> static void Rectangle(int frame_size, T &sum_output, T *values);
+	template<typename T> static void Triangluar(int frame_size, T &sum_output, T *values);
+	template<typename T> static void Bartlett(int frame_size, T &sum_output, T *values);
+	template<typename T> static void Sine(int frame_size, T &sum_output, T *values);
+	template<typename T> static void Hann(int frame_size, T &sum_output, T *values);
+	template<typename T> static void Hamming(int frame_size, T &sum_output, T *values);
+	template<typename T> static void Welch(int frame_size, T &sum_output, T *values);
+	template<typename T> static void Blackman(int frame_size, T &sum_output, T *values);
+	template<typename T> static void Nuttall(int frame_size, T &sum_output, T *values);
+	template<typename T> static void BlackmanNuttall(int frame_size, T &sum_output, T *values);
+	template<typename T> static void BlackmanHarris(int frame_size, T &sum_output, T *values);
+	template<typename T> static void FlatTop(int frame_size, T &sum_output, T *values);
 
 private:
 	static inline float N_MINUS_1(int N)
@@ -49,6 +49,13 @@ CFLAGS                 += -O3 -fassociative-math -freciprocal-math -ffast-math
 
 endif
 
+##
+## Debug check for memory allocation inside execute(), see fftaAllocCheck
+##
+ifdef RT_ALLOC_CHECK
+CXXFLAGS               += -DFFTA_RT_ALLOC_CHECK
+endif
+
 CudaPath               :=/usr/local/cuda
 ConfigurationName      :=$(BuildType)
 IntermediateDirectory  :=./$(BuildType)
@@ -78,7 +85,7 @@ StaticLinkerOptions    :=
 ##
 ## User defined environment variables
 ##
-Objects=$(IntermediateDirectory)/fftaudio_windows.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_cuda.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_base.cpp$(ObjectSuffix) 
+Objects=$(IntermediateDirectory)/fftaudio_windows.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_cuda.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_base.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_simd.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_stream.cpp$(ObjectSuffix) 
 
 ##
 ## Main Build Targets 
@@ -119,6 +126,18 @@ $(IntermediateDirectory)/fftaudio_base.cpp$(ObjectSuffix): source/fftaudio_base.
 $(IntermediateDirectory)/fftaudio_base.cpp$(DependSuffix): source/fftaudio_base.cpp
 	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_base.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_base.cpp$(DependSuffix) -MM source/fftaudio_base.cpp
 
+$(IntermediateDirectory)/fftaudio_simd.cpp$(ObjectSuffix): source/fftaudio_simd.cpp $(IntermediateDirectory)/fftaudio_simd.cpp$(DependSuffix)
+	$(CXX) $(SourceSwitch) "./source/fftaudio_simd.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/fftaudio_simd.cpp$(ObjectSuffix) $(IncludePath)
+
+$(IntermediateDirectory)/fftaudio_simd.cpp$(DependSuffix): source/fftaudio_simd.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_simd.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_simd.cpp$(DependSuffix) -MM source/fftaudio_simd.cpp
+
+$(IntermediateDirectory)/fftaudio_stream.cpp$(ObjectSuffix): source/fftaudio_stream.cpp $(IntermediateDirectory)/fftaudio_stream.cpp$(DependSuffix)
+	$(CXX) $(SourceSwitch) "./source/fftaudio_stream.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/fftaudio_stream.cpp$(ObjectSuffix) $(IncludePath)
+
+$(IntermediateDirectory)/fftaudio_stream.cpp$(DependSuffix): source/fftaudio_stream.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_stream.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_stream.cpp$(DependSuffix) -MM source/fftaudio_stream.cpp
+
 -include $(IntermediateDirectory)/*$(DependSuffix)
 
 ##
@@ -49,6 +49,13 @@ CFLAGS                 += -O3 -fassociative-math -freciprocal-math -ffast-math
 
 endif
 
+##
+## Debug check for memory allocation inside execute(), see fftaAllocCheck
+##
+ifdef RT_ALLOC_CHECK
+CXXFLAGS               += -DFFTA_RT_ALLOC_CHECK
+endif
+
 ConfigurationName      :=$(BuildType)
 IntermediateDirectory  :=./$(BuildType)
 OutDir                 :=$(IntermediateDirectory)
@@ -69,7 +76,7 @@ ObjectSwitch           :=-o
 MakeDirCommand         :=mkdir -p
 IncludePath            :=$(IncludeSwitch). $(IncludeSwitch)./source $(IncludeSwitch)./include
 LibPath                :=
-SharedLibs             :=$(LibrarySwitch)fftw3f
+SharedLibs             :=$(LibrarySwitch)fftw3f $(LibrarySwitch)fftw3f_threads $(LibrarySwitch)fftw3 $(LibrarySwitch)fftw3_threads
 SharedLinkerOptions    :=
 StaticLibs             :=/usr/lib/x86_64-linux-gnu/libfftw3.a
 StaticLinkerOptions    :=
@@ -77,19 +84,43 @@ StaticLinkerOptions    :=
 ##
 ## User defined environment variables
 ##
-Objects=$(IntermediateDirectory)/fftaudio_windows.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_fftw.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_base.cpp$(ObjectSuffix) 
+Objects=$(IntermediateDirectory)/fftaudio_windows.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_fftw.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_base.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_simd.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_barrier.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_arena.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_stream.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_convolver.cpp$(ObjectSuffix) $(IntermediateDirectory)/fftaudio_gccphat.cpp$(ObjectSuffix) 
+
+##
+## Tools
+##
+WisdomOutputFile       :=./$(BuildType)/ffta_wisdom
+BenchOutputFile        :=./$(BuildType)/ffta_bench
+CheckOutputFile        :=./$(BuildType)/ffta_check
+ToolLinkerOptions      :=$(LibrarySwitch)pthread
 
 ##
 ## Main Build Targets 
 ##
-.PHONY: all clean MakeIntermediateDirs
+.PHONY: all clean wisdom bench check MakeIntermediateDirs
 all: $(SharedOutputFile)
 
+wisdom: $(WisdomOutputFile)
+
+bench: $(BenchOutputFile)
+
+check: $(CheckOutputFile)
+	$(CheckOutputFile)
+
 $(SharedOutputFile): $(IntermediateDirectory)/.d $(Objects) 
 	@$(MakeDirCommand) $(@D)
 	@echo "" > $(IntermediateDirectory)/.d
 	$(SharedLinkerName) $(SharedLinkerFlags) $(OutputSwitch)$(SharedOutputFile) $(Objects) $(LibPath) $(SharedLibs) $(SharedLinkerOptions)
 
+$(WisdomOutputFile): $(IntermediateDirectory)/.d $(Objects) tools/ffta_wisdom.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) ./tools/ffta_wisdom.cpp $(Objects) $(OutputSwitch)$(WisdomOutputFile) $(LibPath) $(SharedLibs) $(ToolLinkerOptions)
+
+$(BenchOutputFile): $(IntermediateDirectory)/.d $(Objects) tools/ffta_bench.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) ./tools/ffta_bench.cpp $(Objects) $(OutputSwitch)$(BenchOutputFile) $(LibPath) $(SharedLibs) $(ToolLinkerOptions)
+
+$(CheckOutputFile): $(IntermediateDirectory)/.d $(Objects) tools/ffta_check.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) ./tools/ffta_check.cpp $(Objects) $(OutputSwitch)$(CheckOutputFile) $(LibPath) $(SharedLibs) $(ToolLinkerOptions)
+
 MakeIntermediateDirs:
 	@test -d ./$(BuildType) || $(MakeDirCommand) ./$(BuildType)
 
@@ -118,6 +149,42 @@ $(IntermediateDirectory)/fftaudio_base.cpp$(ObjectSuffix): source/fftaudio_base.
 $(IntermediateDirectory)/fftaudio_base.cpp$(DependSuffix): source/fftaudio_base.cpp
 	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_base.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_base.cpp$(DependSuffix) -MM source/fftaudio_base.cpp
 
+$(IntermediateDirectory)/fftaudio_simd.cpp$(ObjectSuffix): source/fftaudio_simd.cpp $(IntermediateDirectory)/fftaudio_simd.cpp$(DependSuffix)
+	$(CXX) $(SourceSwitch) "./source/fftaudio_simd.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/fftaudio_simd.cpp$(ObjectSuffix) $(IncludePath)
+
+$(IntermediateDirectory)/fftaudio_simd.cpp$(DependSuffix): source/fftaudio_simd.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_simd.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_simd.cpp$(DependSuffix) -MM source/fftaudio_simd.cpp
+
+$(IntermediateDirectory)/fftaudio_barrier.cpp$(ObjectSuffix): source/fftaudio_barrier.cpp $(IntermediateDirectory)/fftaudio_barrier.cpp$(DependSuffix)
+	$(CXX) $(SourceSwitch) "./source/fftaudio_barrier.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/fftaudio_barrier.cpp$(ObjectSuffix) $(IncludePath)
+
+$(IntermediateDirectory)/fftaudio_barrier.cpp$(DependSuffix): source/fftaudio_barrier.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_barrier.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_barrier.cpp$(DependSuffix) -MM source/fftaudio_barrier.cpp
+
+$(IntermediateDirectory)/fftaudio_arena.cpp$(ObjectSuffix): source/fftaudio_arena.cpp $(IntermediateDirectory)/fftaudio_arena.cpp$(DependSuffix)
+	$(CXX) $(SourceSwitch) "./source/fftaudio_arena.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/fftaudio_arena.cpp$(ObjectSuffix) $(IncludePath)
+
+$(IntermediateDirectory)/fftaudio_arena.cpp$(DependSuffix): source/fftaudio_arena.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_arena.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_arena.cpp$(DependSuffix) -MM source/fftaudio_arena.cpp
+
+$(IntermediateDirectory)/fftaudio_stream.cpp$(ObjectSuffix): source/fftaudio_stream.cpp $(IntermediateDirectory)/fftaudio_stream.cpp$(DependSuffix)
+	$(CXX) $(SourceSwitch) "./source/fftaudio_stream.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/fftaudio_stream.cpp$(ObjectSuffix) $(IncludePath)
+
+$(IntermediateDirectory)/fftaudio_stream.cpp$(DependSuffix): source/fftaudio_stream.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_stream.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_stream.cpp$(DependSuffix) -MM source/fftaudio_stream.cpp
+
+$(IntermediateDirectory)/fftaudio_convolver.cpp$(ObjectSuffix): source/fftaudio_convolver.cpp $(IntermediateDirectory)/fftaudio_convolver.cpp$(DependSuffix)
+	$(CXX) $(SourceSwitch) "./source/fftaudio_convolver.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/fftaudio_convolver.cpp$(ObjectSuffix) $(IncludePath)
+
+$(IntermediateDirectory)/fftaudio_convolver.cpp$(DependSuffix): source/fftaudio_convolver.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_convolver.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_convolver.cpp$(DependSuffix) -MM source/fftaudio_convolver.cpp
+
+$(IntermediateDirectory)/fftaudio_gccphat.cpp$(ObjectSuffix): source/fftaudio_gccphat.cpp $(IntermediateDirectory)/fftaudio_gccphat.cpp$(DependSuffix)
+	$(CXX) $(SourceSwitch) "./source/fftaudio_gccphat.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/fftaudio_gccphat.cpp$(ObjectSuffix) $(IncludePath)
+
+$(IntermediateDirectory)/fftaudio_gccphat.cpp$(DependSuffix): source/fftaudio_gccphat.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/fftaudio_gccphat.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/fftaudio_gccphat.cpp$(DependSuffix) -MM source/fftaudio_gccphat.cpp
+
 -include $(IntermediateDirectory)/*$(DependSuffix)
 
 ##
@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include	<cerrno>
+#include	<cstdint>
+#include	<cstdio>
+#include	<unistd.h>
+#include	<sys/mman.h>
+
+#include	<fftaudio_arena.h>
+
+
+static inline size_t
+_round_up(size_t value, size_t multiple)
+{
+	return ((value + multiple - 1) / multiple) * multiple;
+}
+
+
+/***************************************************************
+ * fftaArena Destructor
+ ***************************************************************/
+
+fftaArena::~fftaArena()
+{
+	if(m_mapping != nullptr) {
+		::munmap(m_mapping, m_mappingSize);
+	}
+}
+
+
+/***************************************************************
+ * fftaArena::reserve()
+ ***************************************************************/
+
+size_t
+fftaArena::reserve(size_t size, size_t alignment)
+{
+	size_t		offset = _round_up(m_size, alignment);
+
+	m_size = offset + size;
+
+	if(alignment > m_alignment) {
+		m_alignment = alignment;
+	}
+
+	return offset;
+}
+
+
+/***************************************************************
+ * fftaArena::allocate()
+ ***************************************************************/
+
+int
+fftaArena::allocate(fftaHugePageMode mode)
+{
+	size_t		page_sz = (size_t)::sysconf(_SC_PAGESIZE);
+	size_t		huge_sz = getHugePageSize();
+	size_t		advise_sz;
+	int			err;
+
+	if(m_size == 0) {
+		return 0;
+	}
+
+	/*
+	 * MAP_HUGETLB fails unless enough pages are reserved in the pool
+	 */
+	if(mode == FFTA_HUGE_PAGES_EXPLICIT) {
+		if(this->_map(m_size, m_alignment, huge_sz, MAP_HUGETLB) == 0) {
+			m_hugePageMode = FFTA_HUGE_PAGES_EXPLICIT;
+			return 0;
+		}
+
+		mode = FFTA_HUGE_PAGES_TRANSPARENT;
+	}
+
+	if(mode == FFTA_HUGE_PAGES_TRANSPARENT) {
+		/*
+		 * The advised range must be whole huge pages inside the mapping,
+		 * otherwise the tail is either ineligible or, past the end, the advice
+		 * fails or applies to a neighbouring mapping
+		 */
+		advise_sz = _round_up(m_size, huge_sz);
+
+		if((err = this->_map(advise_sz, (m_alignment > huge_sz) ? m_alignment : huge_sz, page_sz, 0)) != 0) {
+			return err;
+		}
+
+		/*
+		 * Without transparent huge page support the region keeps regular pages
+		 */
+		if(::madvise(m_base, advise_sz, MADV_HUGEPAGE) == 0) {
+			m_hugePageMode = FFTA_HUGE_PAGES_TRANSPARENT;
+		}
+
+		return 0;
+	}
+
+	return this->_map(m_size, m_alignment, page_sz, 0);
+}
+
+
+/***************************************************************
+ * fftaArena::getHugePageSize()
+ ***************************************************************/
+
+size_t
+fftaArena::getHugePageSize()
+{
+	FILE		*fp;
+	char		line[128];
+	unsigned long	size_kb = 0;
+
+	if((fp = ::fopen("/proc/meminfo", "r")) != nullptr) {
+		while(::fgets(line, sizeof(line), fp) != nullptr) {
+			if(::sscanf(line, "Hugepagesize: %lu kB", &size_kb) == 1) {
+				break;
+			}
+		}
+
+		::fclose(fp);
+	}
+
+	return (size_kb > 0) ? (size_t)size_kb * 1024 : (size_t)2 * 1024 * 1024;
+}
+
+
+/***************************************************************
+ ****************** Private Member Functions *******************
+ ***************************************************************/
+
+/*
+ * Maps at least 'size' bytes ('m_size' or more) after a base aligned to
+ * 'alignment', in units of 'granule' bytes (the page size of the mapping)
+ *
+ *	  Returns 0 or the mmap() errno
+ */
+int
+fftaArena::_map(size_t size, size_t alignment, size_t granule, int flags)
+{
+	size_t		extra = (alignment > granule) ? alignment - granule : 0;
+	size_t		length = _round_up(size + extra, granule);
+	void		*mapping;
+
+	mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+	if(mapping == MAP_FAILED) {
+		return errno;
+	}
+
+	m_mapping = mapping;
+	m_mappingSize = length;
+	m_base = (char *)_round_up((size_t)(uintptr_t)mapping, alignment);
+	return 0;
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FFTA__ARENA__H__
+#define FFTA__ARENA__H__
+
+
+#include	<cstddef>
+
+
+//
+// Huge page modes, for use with setHugePages()
+//
+typedef enum ffta_huge_page_mode_enum {
+	// Regular pages, the kernel may still use transparent huge pages if
+	// enabled system-wide (default)
+	FFTA_HUGE_PAGES_NONE = 0,
+
+	// The region is aligned to and sized in whole huge pages, and marked
+	// with madvise(MADV_HUGEPAGE)
+	FFTA_HUGE_PAGES_TRANSPARENT,
+
+	// The region is mapped with MAP_HUGETLB from the reserved huge page pool
+	// (/proc/sys/vm/nr_hugepages), falling back to FFTA_HUGE_PAGES_TRANSPARENT
+	// when the pool can't satisfy it
+	FFTA_HUGE_PAGES_EXPLICIT
+} fftaHugePageMode;
+
+
+//
+// Single-region buffer arena.  Buffers are first reserved, which only
+// assigns each one an aligned offset, then allocate() maps one anonymous
+// region holding all of them.  The region is zero filled and unmapped by the
+// destructor.
+//
+class fftaArena
+{
+public:
+	fftaArena() = default;
+	~fftaArena();
+
+	/*
+	 * reserve()
+	 *
+	 * Reserves 'size' bytes at an offset aligned to 'alignment' (a power of
+	 * two), must be called before allocate()
+	 *
+	 *	  Returns the offset of the buffer, for use with at()
+	 */
+	size_t reserve(size_t size, size_t alignment);
+
+	/*
+	 * allocate()
+	 *
+	 * Maps the region holding every reserved buffer
+	 *
+	 * mode - 'fftaHugePageMode' value
+	 *
+	 *	  Returns 0 or the mmap() errno
+	 */
+	int allocate(fftaHugePageMode mode);
+
+	/*
+	 * at()
+	 *
+	 * Returns the address of the buffer reserved at 'offset', valid after
+	 * allocate()
+	 */
+	void *at(size_t offset) const					{ return m_base + offset;				}
+
+	/*
+	 * getBase() / getSize()
+	 *
+	 * Returns the address and size of the reserved buffers, valid after
+	 * allocate()
+	 */
+	void *getBase() const							{ return m_base;						}
+	size_t getSize() const							{ return m_size;						}
+
+	/*
+	 * getHugePageMode()
+	 *
+	 * Returns the huge page mode in effect, which differs from the one
+	 * requested when explicit huge pages weren't available
+	 */
+	fftaHugePageMode getHugePageMode() const		{ return m_hugePageMode;				}
+
+	/*
+	 * getHugePageSize()
+	 *
+	 * Returns the default huge page size, from /proc/meminfo
+	 */
+	static size_t getHugePageSize();
+
+private:
+	int			_map(size_t size, size_t alignment, size_t granule, int flags);
+
+private:
+	char					*m_base = nullptr;
+	size_t					m_size = 0;
+	size_t					m_alignment = 1;
+	void					*m_mapping = nullptr;
+	size_t					m_mappingSize = 0;
+	fftaHugePageMode		m_hugePageMode = FFTA_HUGE_PAGES_NONE;
+
+private:
+	fftaArena(const fftaArena &) = delete;
+	fftaArena &operator=(const fftaArena &) = delete;
+};
+
+
+#endif // FFTA__ARENA__H__
@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include	<atomic>
+#include	<climits>
+#include	<unistd.h>
+#include	<sys/syscall.h>
+#include	<linux/futex.h>
+
+#include	<fftaudio_barrier.h>
+
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex requires a plain 32-bit word");
+
+
+static inline void
+_cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+
+/***************************************************************
+ * fftaBarrier Constructor
+ ***************************************************************/
+
+fftaBarrier::fftaBarrier()
+{
+	m_remaining = 0;
+	m_sense = 0;
+	m_sleepers = 0;
+}
+
+
+/***************************************************************
+ * fftaBarrier::initialize()
+ ***************************************************************/
+
+void
+fftaBarrier::initialize(int participants, int spin_count)
+{
+	m_participants = participants;
+	m_spinCount = spin_count;
+	m_remaining.store(participants, std::memory_order_relaxed);
+	m_sense.store(0, std::memory_order_relaxed);
+	m_sleepers.store(0, std::memory_order_relaxed);
+}
+
+
+/***************************************************************
+ * fftaBarrier::wait()
+ ***************************************************************/
+
+void
+fftaBarrier::wait(int &local_sense)
+{
+	local_sense = !local_sense;
+
+	/*
+	 * Last thread to arrive resets the count for the next episode and then
+	 * flips the shared sense, releasing everyone else
+	 */
+	if(m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		m_remaining.store(m_participants, std::memory_order_relaxed);
+		m_sense.store(local_sense, std::memory_order_seq_cst);
+
+		if(m_sleepers.load(std::memory_order_seq_cst) > 0) {
+			this->_futex_wake();
+		}
+
+		return;
+	}
+
+	for(int i = 0; i < m_spinCount; ++i) {
+		if(m_sense.load(std::memory_order_acquire) == local_sense) {
+			return;
+		}
+
+		_cpu_relax();
+	}
+
+	/*
+	 * Register as a sleeper before re-checking the sense, the releasing thread
+	 * only makes the wake syscall when it sees a sleeper
+	 */
+	m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+	while(m_sense.load(std::memory_order_seq_cst) != local_sense) {
+		this->_futex_wait(!local_sense);
+	}
+
+	m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+/***************************************************************
+ ****************** Private Member Functions *******************
+ ***************************************************************/
+
+void
+fftaBarrier::_futex_wait(int expected)
+{
+	::syscall(SYS_futex, reinterpret_cast<int *>(&m_sense), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+
+void
+fftaBarrier::_futex_wake()
+{
+	::syscall(SYS_futex, reinterpret_cast<int *>(&m_sense), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
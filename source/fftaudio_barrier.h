@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FFTA__BARRIER__H__
+#define FFTA__BARRIER__H__
+
+
+#include	<atomic>
+
+
+//
+// Sense-reversing barrier used for low-latency dispatch.  Waiting threads
+// spin for a bounded number of iterations and then sleep on a futex, so
+// short waits never enter the kernel and long waits don't burn a cpu.
+//
+class fftaBarrier
+{
+public:
+	fftaBarrier();
+	~fftaBarrier() = default;
+
+	/*
+	 * initialize()
+	 *
+	 * Sets the number of participating threads, must be called before any
+	 * thread calls wait()
+	 *
+	 * participants - number of threads that must call wait() to release it
+	 * spin_count - number of polling iterations before sleeping
+	 */
+	void initialize(int participants, int spin_count);
+
+	/*
+	 * wait()
+	 *
+	 * Blocks until all participants have called wait().  Memory written by any
+	 * participant before wait() is visible to all participants after it.
+	 *
+	 * local_sense - per-thread sense flag, must start at 0 and only be used
+	 *			with this barrier
+	 */
+	void wait(int &local_sense);
+
+private:
+	void		_futex_wait(int expected);
+	void		_futex_wake();
+
+private:
+	std::atomic<int>		m_remaining;
+	std::atomic<int>		m_sense;
+	std::atomic<int>		m_sleepers;
+	int						m_participants = 0;
+	int						m_spinCount = 0;
+
+private:
+	fftaBarrier(const fftaBarrier &) = delete;
+	fftaBarrier &operator=(const fftaBarrier &) = delete;
+};
+
+
+#endif // FFTA__BARRIER__H__
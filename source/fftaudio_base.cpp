@@ -15,45 +15,327 @@
 //
 ///////////////////////////////////////////////////////////////////////////
 
+#include	<cfloat>
+#include	<cstdio>
 #include	<cstdlib>
 #include	<cstdint>
 #include	<cstring>
-#include	<math.h>
+#include	<cmath>
+#include	<algorithm>
+#include	<new>
 #include	<values.h>
 #include	<vector>
 
 #include	<fftaudio_base.h>
+#include	<fftaudio_simd.h>
 #include	<fftaudio_status.h>
 #include	<fftaudio_windows.h>
 
 
+template<typename T>
+std::vector<typename FFTAudioBaseT<T>::windowEntry *>	FFTAudioBaseT<T>::sm_windowCache;
+
+template<typename T>
+pthread_mutex_t		FFTAudioBaseT<T>::sm_windowMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*
+ * Precision specific kernels, float uses the vectorized fftaSimd kernels and
+ * double plain loops
+ */
+static inline void
+_convert_s16(const short *in, const float *window, float *out, int count)
+{
+	fftaSimd::convertS16(in, window, out, count);
+}
+
+static inline void
+_convert_s16(const short *in, const double *window, double *out, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		out[i] = (double)in[i] * window[i];
+	}
+}
+
+static inline void
+_convert_s32(const int32_t *in, const float *window, float scale, float *out, int count)
+{
+	fftaSimd::convertS32(in, window, scale, out, count);
+}
+
+static inline void
+_convert_s32(const int32_t *in, const double *window, double scale, double *out, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		out[i] = (double)in[i] * scale * window[i];
+	}
+}
+
+static inline void
+_convert_float(const float *in, const float *window, float *out, int count)
+{
+	fftaSimd::convertF32(in, window, out, count);
+}
+
+template<typename S, typename T>
+static inline void
+_convert_float(const S *in, const T *window, T *out, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		out[i] = (T)in[i] * window[i];
+	}
+}
+
+static inline float
+_weighted_power(const float *complex_in, const float *weights, int count)
+{
+	return fftaSimd::weightedPower(complex_in, weights, count);
+}
+
+static inline double
+_weighted_power(const double *complex_in, const double *weights, int count)
+{
+	double	sum = 0.0;
+
+	for(int i = 0; i < count; ++i) {
+		sum += weights[i] * ((complex_in[2 * i] * complex_in[2 * i]) + (complex_in[2 * i + 1] * complex_in[2 * i + 1]));
+	}
+
+	return sum;
+}
+
+static inline void
+_complex_multiply(const float *a, const float *b, float *out, int count)
+{
+	fftaSimd::complexMultiply(a, b, out, count);
+}
+
+static inline void
+_complex_multiply(const double *a, const double *b, double *out, int count)
+{
+	double	re;
+	double	im;
+
+	for(int i = 0; i < count; ++i) {
+		re = (a[2 * i] * b[2 * i]) - (a[(2 * i) + 1] * b[(2 * i) + 1]);
+		im = (a[2 * i] * b[(2 * i) + 1]) + (a[(2 * i) + 1] * b[2 * i]);
+		out[2 * i] = re;
+		out[(2 * i) + 1] = im;
+	}
+}
+
+static inline void
+_goertzel(const float *in, int count, const double *cosines, const double *sines, float *out, int target_count)
+{
+	fftaSimd::goertzel(in, count, cosines, sines, out, target_count);
+}
+
+static inline void
+_goertzel(const double *in, int count, const double *cosines, const double *sines, double *out, int target_count)
+{
+	double	coeff;
+	double	s0;
+	double	s1;
+	double	s2;
+
+	for(int t = 0; t < target_count; ++t) {
+		coeff = 2.0 * cosines[t];
+		s1 = 0.0;
+		s2 = 0.0;
+
+		for(int i = 0; i < count; ++i) {
+			s0 = in[i] + (coeff * s1) - s2;
+			s2 = s1;
+			s1 = s0;
+		}
+
+		out[2 * t] = s1 - (cosines[t] * s2);
+		out[(2 * t) + 1] = sines[t] * s2;
+	}
+}
+
+static inline void
+_accumulate_power(const float *complex_in, float *acc, int count, float weight)
+{
+	fftaSimd::accumulatePower(complex_in, acc, count, weight);
+}
+
+static inline void
+_accumulate_power(const double *complex_in, double *acc, int count, double weight)
+{
+	for(int i = 0; i < count; ++i) {
+		acc[i] += weight * ((complex_in[2 * i] * complex_in[2 * i])
+								+ (complex_in[(2 * i) + 1] * complex_in[(2 * i) + 1]));
+	}
+}
+
+static inline void
+_peak_power(const float *complex_in, float *acc, int count, float scale)
+{
+	fftaSimd::peakPower(complex_in, acc, count, scale);
+}
+
+static inline void
+_peak_power(const double *complex_in, double *acc, int count, double scale)
+{
+	for(int i = 0; i < count; ++i) {
+		acc[i] = std::max(acc[i], scale * ((complex_in[2 * i] * complex_in[2 * i])
+											+ (complex_in[(2 * i) + 1] * complex_in[(2 * i) + 1])));
+	}
+}
+
+static inline void
+_element_maximum(float *data, const float *values, int count)
+{
+	fftaSimd::elementMaximum(data, values, count);
+}
+
+static inline void
+_element_maximum(double *data, const double *values, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] = std::max(data[i], values[i]);
+	}
+}
+
+static inline void
+_multiply(float *data, const float *factors, int count)
+{
+	fftaSimd::multiply(data, factors, count);
+}
+
+static inline void
+_multiply(double *data, const double *factors, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] *= factors[i];
+	}
+}
+
+static inline void
+_add(float *data, const float *terms, int count)
+{
+	fftaSimd::add(data, terms, count);
+}
+
+static inline void
+_add(double *data, const double *terms, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] += terms[i];
+	}
+}
+
+static inline void
+_affine(float *data, int count, float scale, float offset)
+{
+	fftaSimd::affine(data, count, scale, offset);
+}
+
+static inline void
+_affine(double *data, int count, double scale, double offset)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] = (data[i] * scale) + offset;
+	}
+}
+
+static inline void
+_clamp(float *data, int count, float low, float high)
+{
+	fftaSimd::clamp(data, count, low, high);
+}
+
+static inline void
+_clamp(double *data, int count, double low, double high)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] = std::min(std::max(data[i], low), high);
+	}
+}
+
+static inline void
+_log_scale(float *data, int count, float scale)
+{
+	fftaSimd::logScale(data, count, scale);
+}
+
+static inline void
+_log_scale(double *data, int count, double scale)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] = std::log10(std::max(data[i], DBL_MIN)) * scale;
+	}
+}
+
+static inline float
+_maximum(const float *data, int count)
+{
+	return fftaSimd::maximum(data, count);
+}
+
+static inline double
+_maximum(const double *data, int count)
+{
+	double	ret = data[0];
+
+	for(int i = 1; i < count; ++i) {
+		ret = std::max(ret, data[i]);
+	}
+
+	return ret;
+}
+
+static inline void
+_magnitude(const float *complex_in, float *out, int count, float scale)
+{
+	fftaSimd::magnitude(complex_in, out, count, scale);
+}
+
+static inline void
+_magnitude(const double *complex_in, double *out, int count, double scale)
+{
+	for(int i = 0; i < count; ++i) {
+		out[i] = std::sqrt((complex_in[2 * i] * complex_in[2 * i]) + (complex_in[2 * i + 1] * complex_in[2 * i + 1])) * scale;
+	}
+}
+
+
 /***************************************************************
- * FFTAudioBase Constructor Implementation
+ * FFTAudioBaseT Constructor Implementation
  ***************************************************************/
 
-FFTAudioBase::FFTAudioBase(FuncInitWindowCB window_type, int sample_rate,
-						   int frame_size, int padded_frame_size, int batch_count)
+template<typename T>
+FFTAudioBaseT<T>::FFTAudioBaseT(FuncInitWindowCB window_type, int sample_rate,
+								 int frame_size, int padded_frame_size, int batch_count)
 {
 	m_sampleRate = sample_rate;
 	m_frameSize = frame_size;
 	m_paddedFrameSize = padded_frame_size;
 	m_batchCount = batch_count;
 	m_binCount = m_paddedFrameSize / 2;
-	m_frequencyStep = (float)m_sampleRate / (float)m_paddedFrameSize;
+	m_frequencyStep = (T)m_sampleRate / (T)m_paddedFrameSize;
 	m_windowInitCallback = window_type;
 	m_getBinCallback = nullptr;
 	m_getBinCallbackUserPointer = nullptr;
+	m_getBinsCallback = nullptr;
+	m_getBinsCallbackUserPointer = nullptr;
 }
 
 
 /***************************************************************
- * FFTAudioBase Destructor Implementation
+ * FFTAudioBaseT Destructor Implementation
  ***************************************************************/
 
-FFTAudioBase::~FFTAudioBase()
+template<typename T>
+FFTAudioBaseT<T>::~FFTAudioBaseT()
 {
-	if(m_windowValues != nullptr) {
-		::free(m_windowValues);
+	if(m_window != nullptr) {
+		_release_window(m_window);
+	}
+
+	if(m_statsCounters != nullptr) {
+		::free(m_statsCounters);
 	}
 
 	// Note: m_inputBuffer is a member of this base class, but is allocated
@@ -63,11 +345,12 @@ FFTAudioBase::~FFTAudioBase()
 
 
 /***************************************************************
- * FFTAudioBase::initialize()
+ * FFTAudioBaseT::initialize()
  ***************************************************************/
 
+template<typename T>
 fftaStatus
-FFTAudioBase::initialize()
+FFTAudioBaseT<T>::initialize()
 {
 	/*
 	 * Previous initialization failed
@@ -89,19 +372,32 @@ FFTAudioBase::initialize()
 	 */
 	if(m_paddedFrameSize == 0) {
 		m_paddedFrameSize = m_frameSize;
+		m_binCount = m_paddedFrameSize / 2;
+		m_frequencyStep = (T)m_sampleRate / (T)m_paddedFrameSize;
 	}
 	else if(m_paddedFrameSize < m_frameSize) {
 		m_initializeFailed = true;
 		return FFTA_INVALID_ARGUMENT;
 	}
 
-	m_windowValues = (float *)::malloc(m_frameSize * sizeof(float));
-	if(m_windowValues == nullptr) {
-		m_initializeFailed = true;
-		return FFTA_ALLOC_FAILED;
+	m_transformBinCount = m_paddedFrameSize / 2;
+	m_binSpacing = m_frequencyStep;
+
+	/*
+	 * Target frequencies replace the bin grid, the mel and peak stages need it
+	 */
+	if(!m_targetFrequencies.empty()) {
+		if(m_melBandCount > 0 || m_peakMaxCount > 0 || m_zoomBinCount > 0) {
+			m_initializeFailed = true;
+			return FFTA_INVALID_ARGUMENT;
+		}
+
+		this->_init_target_bins();
 	}
 
-	::memset(m_windowValues, 0, m_frameSize * sizeof(float));
+	if(m_zoomBinCount > 0) {
+		this->_init_zoom();
+	}
 
 	/*
 	 * If window initialization function is null, set to Rectangle
@@ -111,52 +407,1955 @@ FFTAudioBase::initialize()
 	}
 
 	/*
-	 * Call the specified window initialization function to initialize the
-	 * m_windowSum and m_windowValues variables.
+	 * Window tables are shared by every instance with the same window function
+	 * and frame size
 	 */
-	(*m_windowInitCallback)(m_frameSize, m_windowSum, m_windowValues);
-	return FFTA_SUCCESS;
-}
-
-
-/***************************************************************
- * FFTAudioBase::getBinValue()
- ***************************************************************/
+	m_window = _acquire_window(m_windowInitCallback, m_frameSize);
+	if(m_window == nullptr) {
+		m_initializeFailed = true;
+		return FFTA_ALLOC_FAILED;
+	}
 
-float
-FFTAudioBase::getBinValue(int batch_index, int bin_index) const
-{
-	int		idx;
-	float	ret;
+	m_windowValues = m_window->wdm_values;
+	m_scaledWindowValues = &m_window->wdm_values[m_frameSize];
+	m_windowSum = m_window->wdm_windowSum;
 
-	idx = (batch_index * (m_binCount + 1)) + bin_index;
+	/*
+	 * The vectorized input kernels replace _prepare_input_value(), so they are
+	 * only used when it isn't overridden
+	 */
+	m_vectorizedInput = this->_has_default_input_conversion();
 
 	/*
-	 * Call virtual function _get_complex_result(), which uses the underlying
-	 * api's complex type and returns: real^2 + complex^2
+	 * Lay out the output of the enabled output stages
 	 */
-	ret = this->_get_complex_result(idx);
+	m_postProcessSize = 0;
+
+	if(!m_spectrumStages.empty()) {
+		this->_init_spectrum_stages();
+
+		m_spectrumOffset = m_postProcessSize;
+		m_postProcessSize += m_binCount + 1;
+	}
+
+	if(m_melBandCount > 0) {
+		if(m_melMaxFrequency == 0) {
+			m_melMaxFrequency = (T)m_sampleRate / (T)2.0;
+		}
+
+		if(m_melMinFrequency >= m_melMaxFrequency) {
+			m_initializeFailed = true;
+			return FFTA_INVALID_ARGUMENT;
+		}
+
+		this->_init_mel_filterbank();
+
+		m_melOffset = m_postProcessSize;
+		m_postProcessSize += m_melBandCount;
+		m_mfccOffset = m_postProcessSize;
+		m_postProcessSize += m_mfccCount;
+	}
+
+	if(m_peakMaxCount > 0) {
+		m_peakOffset = m_postProcessSize;
+		m_postProcessSize += 1 + (3 * m_peakMaxCount);
+		m_peakScratchOffset = m_postProcessSize;
+		m_postProcessSize += m_binCount + 1;
+	}
+
+	for(size_t i = 0; i < m_spectrumStages.size(); ++i) {
+		if(m_spectrumStages[i].ssm_stage == FFTA_STAGE_SMOOTH) {
+			m_spectrumScratchOffset = m_postProcessSize;
+			m_postProcessSize += m_binCount + 1;
+			break;
+		}
+	}
 
 	/*
-	 * Default bin result post-processing
+	 * Distance between the slices of consecutive batches, packed unless the
+	 * derived class set a slice alignment
 	 */
-	ret = sqrtf(ret);
-	ret *= 2.0f;
-	ret /= m_windowSum;
+	m_outputStride = this->_align_slice(m_binCount + 1, 2 * sizeof(T));
+	m_postProcessStride = this->_align_slice(m_postProcessSize, sizeof(T));
 
 	/*
-	 * Call user-specified post-processing function if set
+	 * Per-batch weights of the average, the power scale (2 / window_sum)^2 is
+	 * folded in.  The exponential weights apply the batches in order, so
+	 * the last batch of a call has weight 'alpha'.
 	 */
-	if(m_getBinCallback != nullptr) {
-		(*m_getBinCallback)(bin_index, ret, m_getBinCallbackUserPointer);
+	if(m_averageMode != FFTA_AVERAGE_NONE) {
+		const T		power_scale = ((T)2.0 / m_windowSum) * ((T)2.0 / m_windowSum);
+
+		m_averageWeights.resize(m_batchCount);
+		m_averageState.assign(m_binCount + 1, (T)0);
+
+		for(int i = 0; i < m_batchCount; ++i) {
+			switch(m_averageMode) {
+			case FFTA_AVERAGE_LINEAR:
+				m_averageWeights[i] = power_scale / (T)m_batchCount;
+				break;
+
+			case FFTA_AVERAGE_EXPONENTIAL:
+				m_averageWeights[i] = power_scale * m_averageAlpha
+										* (T)std::pow(1.0 - (double)m_averageAlpha, (double)(m_batchCount - 1 - i));
+				break;
+
+			default:
+				m_averageWeights[i] = power_scale;
+				break;
+			}
+		}
+
+		m_averageDecay = (T)std::pow(1.0 - (double)m_averageAlpha, (double)m_batchCount);
 	}
 
-	return ret;
+	return FFTA_SUCCESS;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::execute()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const short *data, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_S16, sizeof(short), data, nullptr, channel_stride));
 }
 
 
-float
-FFTAudioBase::getBinValue(int bin_index) const
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const short * const *data_ptrs, int channel_stride)
 {
-	return getBinValue(0, bin_index);
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_S16, sizeof(short), nullptr,
+										  (const void * const *)data_ptrs, channel_stride));
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const fftaInt24 *data, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_S24, sizeof(fftaInt24), data, nullptr, channel_stride));
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const fftaInt24 * const *data_ptrs, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_S24, sizeof(fftaInt24), nullptr,
+										  (const void * const *)data_ptrs, channel_stride));
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const int32_t *data, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_S32, sizeof(int32_t), data, nullptr, channel_stride));
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const int32_t * const *data_ptrs, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_S32, sizeof(int32_t), nullptr,
+										  (const void * const *)data_ptrs, channel_stride));
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const float *data, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_F32, sizeof(float), data, nullptr, channel_stride));
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const float * const *data_ptrs, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_F32, sizeof(float), nullptr,
+										  (const void * const *)data_ptrs, channel_stride));
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const double *data, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_F64, sizeof(double), data, nullptr, channel_stride));
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::execute(const double * const *data_ptrs, int channel_stride)
+{
+	return this->_execute(inputDescriptor(FFTA_SAMPLE_F64, sizeof(double), nullptr,
+										  (const void * const *)data_ptrs, channel_stride));
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::executeAsync()
+ ***************************************************************/
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const short *data, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_S16, sizeof(short), data, nullptr, channel_stride));
+}
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const short * const *data_ptrs, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_S16, sizeof(short), nullptr,
+												(const void * const *)data_ptrs, channel_stride));
+}
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const fftaInt24 *data, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_S24, sizeof(fftaInt24), data, nullptr, channel_stride));
+}
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const fftaInt24 * const *data_ptrs, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_S24, sizeof(fftaInt24), nullptr,
+												(const void * const *)data_ptrs, channel_stride));
+}
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const int32_t *data, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_S32, sizeof(int32_t), data, nullptr, channel_stride));
+}
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const int32_t * const *data_ptrs, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_S32, sizeof(int32_t), nullptr,
+												(const void * const *)data_ptrs, channel_stride));
+}
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const float *data, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_F32, sizeof(float), data, nullptr, channel_stride));
+}
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const float * const *data_ptrs, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_F32, sizeof(float), nullptr,
+												(const void * const *)data_ptrs, channel_stride));
+}
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const double *data, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_F64, sizeof(double), data, nullptr, channel_stride));
 }
+
+
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::executeAsync(const double * const *data_ptrs, int channel_stride)
+{
+	return this->_execute_async(inputDescriptor(FFTA_SAMPLE_F64, sizeof(double), nullptr,
+												(const void * const *)data_ptrs, channel_stride));
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_execute_async() / wait() / selectResult()
+ ***************************************************************/
+
+/*
+ * Default implementation for api's without asynchronous execution, batches
+ * complete before _execute_async() returns and only the latest is readable
+ */
+template<typename T>
+int64_t
+FFTAudioBaseT<T>::_execute_async(const inputDescriptor &input)
+{
+	int64_t		ticket;
+
+	if(!this->_execute(input)) {
+		return -1;
+	}
+
+	ticket = m_syncTickets++;
+	this->_notify_complete(ticket);
+	return ticket;
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::wait(int64_t ticket)
+{
+	return (ticket >= 0 && ticket < m_syncTickets);
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::selectResult(int64_t ticket)
+{
+	return (ticket >= 0 && ticket == m_syncTickets - 1);
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_prepare_input_frame()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_prepare_input_frame(const inputDescriptor &input, int batch_index, T *output)
+{
+	const void	*frame = input.getFrame(batch_index, m_frameSize);
+	int			stride = input.idm_channelStride;
+
+	switch(input.idm_format) {
+	case FFTA_SAMPLE_S16:
+		{
+			const short		*src = (const short *)frame;
+
+			if(!m_vectorizedInput) {
+				// Slow path, derived class overrides _prepare_input_value()
+				for(int i = 0; i < m_frameSize; ++i) {
+					output[i] = this->_prepare_input_value(i, src[i * stride]);
+				}
+			}
+			else if(stride == 1) {
+				_convert_s16(src, m_scaledWindowValues, output, m_frameSize);
+			}
+			else {
+				for(int i = 0; i < m_frameSize; ++i) {
+					output[i] = (T)src[i * stride] * m_scaledWindowValues[i];
+				}
+			}
+		}
+		break;
+
+	case FFTA_SAMPLE_S24:
+		{
+			const uint8_t	*src = (const uint8_t *)frame;
+			const T			scale = (T)1.0 / (T)256.0;
+			int32_t			value;
+
+			for(int i = 0; i < m_frameSize; ++i) {
+				/*
+				 * Assemble in the top 24 bits, arithmetic shift sign-extends
+				 */
+				value = (int32_t)(((uint32_t)src[2] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[0] << 8)) >> 8;
+				output[i] = (T)value * scale * m_scaledWindowValues[i];
+				src += 3 * stride;
+			}
+		}
+		break;
+
+	case FFTA_SAMPLE_S32:
+		{
+			const int32_t	*src = (const int32_t *)frame;
+			const T			scale = (T)1.0 / (T)65536.0;
+
+			if(stride == 1) {
+				_convert_s32(src, m_scaledWindowValues, scale, output, m_frameSize);
+			}
+			else {
+				for(int i = 0; i < m_frameSize; ++i) {
+					output[i] = (T)src[i * stride] * scale * m_scaledWindowValues[i];
+				}
+			}
+		}
+		break;
+
+	case FFTA_SAMPLE_F32:
+		{
+			const float		*src = (const float *)frame;
+
+			if(stride == 1) {
+				_convert_float(src, m_windowValues, output, m_frameSize);
+			}
+			else {
+				for(int i = 0; i < m_frameSize; ++i) {
+					output[i] = (T)src[i * stride] * m_windowValues[i];
+				}
+			}
+		}
+		break;
+
+	case FFTA_SAMPLE_F64:
+		{
+			const double	*src = (const double *)frame;
+
+			if(stride == 1) {
+				_convert_float(src, m_windowValues, output, m_frameSize);
+			}
+			else {
+				for(int i = 0; i < m_frameSize; ++i) {
+					output[i] = (T)src[i * stride] * m_windowValues[i];
+				}
+			}
+		}
+		break;
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_prepare_input_value()
+ ***************************************************************/
+
+template<typename T>
+T
+FFTAudioBaseT<T>::_prepare_input_value(int frame_index, short sample_value)
+{
+	T ret = (T)sample_value;
+
+	ret /= (T)MAXSHORT + (T)1.0;
+	ret *= m_windowValues[frame_index];
+	return ret;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_has_default_input_conversion()
+ ***************************************************************/
+
+/*
+ * Returns true if the object's _prepare_input_value() is the one defined by
+ * this class.  Uses the gcc extension for extracting the function called
+ * through a bound pointer to member function, other compilers always use the
+ * slow path.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpmf-conversions"
+#endif
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::_has_default_input_conversion()
+{
+#if defined(__GNUC__) && !defined(__clang__)
+	typedef T (*FuncPrepareInput)(FFTAudioBaseT *, int, short);
+
+	FuncPrepareInput	actual = (FuncPrepareInput)(this->*(&FFTAudioBaseT::_prepare_input_value));
+	FuncPrepareInput	base = (FuncPrepareInput)(&FFTAudioBaseT::_prepare_input_value);
+
+	return (actual == base);
+#else
+	return false;
+#endif
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+
+/***************************************************************
+ * FFTAudioBaseT::_acquire_window()
+ ***************************************************************/
+
+/*
+ * Returns the shared window entry for 'window_cb' and 'frame_size', computing
+ * it on first use.  Returns nullptr if allocation fails.
+ */
+template<typename T>
+typename FFTAudioBaseT<T>::windowEntry *
+FFTAudioBaseT<T>::_acquire_window(FuncInitWindowCB window_cb, int frame_size)
+{
+	windowEntry		*entry = nullptr;
+
+	::pthread_mutex_lock(&sm_windowMutex);
+
+	for(size_t i = 0; i < sm_windowCache.size(); ++i) {
+		if(sm_windowCache[i]->wdm_windowCallback == window_cb && sm_windowCache[i]->wdm_frameSize == frame_size) {
+			entry = sm_windowCache[i];
+			entry->wdm_refCount++;
+			break;
+		}
+	}
+
+	if(entry == nullptr) {
+		entry = new (std::nothrow) windowEntry();
+
+		/*
+		 * One allocation holds the window values followed by the same values
+		 * with the 16-bit sample scale folded in
+		 */
+		if(entry != nullptr) {
+			entry->wdm_values = (T *)::malloc(2 * frame_size * sizeof(T));
+
+			if(entry->wdm_values == nullptr) {
+				delete entry;
+				entry = nullptr;
+			}
+		}
+
+		if(entry != nullptr) {
+			entry->wdm_windowCallback = window_cb;
+			entry->wdm_frameSize = frame_size;
+			entry->wdm_refCount = 1;
+			entry->wdm_windowSum = 0;
+
+			::memset(entry->wdm_values, 0, 2 * frame_size * sizeof(T));
+
+			(*window_cb)(frame_size, entry->wdm_windowSum, entry->wdm_values);
+
+			for(int i = 0; i < frame_size; ++i) {
+				entry->wdm_values[frame_size + i] = entry->wdm_values[i] / ((T)MAXSHORT + (T)1.0);
+			}
+
+			sm_windowCache.push_back(entry);
+		}
+	}
+
+	::pthread_mutex_unlock(&sm_windowMutex);
+	return entry;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_release_window()
+ ***************************************************************/
+
+/*
+ * Drops a reference to a shared window entry, freeing it with the last one
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_release_window(windowEntry *entry)
+{
+	::pthread_mutex_lock(&sm_windowMutex);
+
+	if(--entry->wdm_refCount == 0) {
+		for(size_t i = 0; i < sm_windowCache.size(); ++i) {
+			if(sm_windowCache[i] == entry) {
+				sm_windowCache.erase(sm_windowCache.begin() + i);
+				break;
+			}
+		}
+
+		::free(entry->wdm_values);
+		delete entry;
+	}
+
+	::pthread_mutex_unlock(&sm_windowMutex);
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getBinValue()
+ ***************************************************************/
+
+template<typename T>
+T
+FFTAudioBaseT<T>::getBinValue(int batch_index, int bin_index) const
+{
+	int		idx;
+	T		ret;
+
+	idx = (batch_index * m_outputStride) + bin_index;
+
+	/*
+	 * Call virtual function _get_complex_result(), which uses the underlying
+	 * api's complex type and returns: real^2 + complex^2
+	 */
+	ret = this->_get_complex_result(idx);
+
+	/*
+	 * Default bin result post-processing
+	 */
+	ret = std::sqrt(ret);
+	ret *= (T)2.0;
+	ret /= m_windowSum;
+
+	/*
+	 * Call user-specified post-processing function if set
+	 */
+	if(m_getBinCallback != nullptr) {
+		(*m_getBinCallback)(bin_index, ret, m_getBinCallbackUserPointer);
+	}
+
+	return ret;
+}
+
+
+template<typename T>
+T
+FFTAudioBaseT<T>::getBinValue(int bin_index) const
+{
+	return getBinValue(0, bin_index);
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getBinValues()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::getBinValues(int batch_index, T *out, int first_bin, int count) const
+{
+	const T			*complex_buf;
+
+	if(!m_initialized || batch_index < 0 || batch_index >= m_batchCount
+			|| first_bin < 0 || count < 0 || first_bin + count > m_binCount + 1) {
+		return false;
+	}
+
+	complex_buf = this->_get_complex_buffer();
+	complex_buf += 2 * (((size_t)batch_index * m_outputStride) + first_bin);
+
+	/*
+	 * Default bin result post-processing, same as getBinValue()
+	 */
+	_magnitude(complex_buf, out, count, (T)2.0 / m_windowSum);
+
+	/*
+	 * Call user-specified post-processing function if set, preferring the
+	 * block callback over the per-bin callback
+	 */
+	if(m_getBinsCallback != nullptr) {
+		(*m_getBinsCallback)(batch_index, first_bin, count, out, m_getBinsCallbackUserPointer);
+	}
+	else if(m_getBinCallback != nullptr) {
+		for(int i = 0; i < count; ++i) {
+			(*m_getBinCallback)(first_bin + i, out[i], m_getBinCallbackUserPointer);
+		}
+	}
+
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getAllBinValues()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::getAllBinValues(T *out, int first_bin, int count) const
+{
+	for(int i = 0; i < m_batchCount; ++i) {
+		if(!getBinValues(i, &out[i * count], first_bin, count)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getComplexSpectrum()
+ ***************************************************************/
+
+template<typename T>
+fftaComplexViewT<T>
+FFTAudioBaseT<T>::getComplexSpectrum(int batch_index) const
+{
+	if(!m_initialized || batch_index < 0 || batch_index >= m_batchCount) {
+		return fftaComplexViewT<T>();
+	}
+
+	return fftaComplexViewT<T>(this->_get_complex_buffer() + (2 * (size_t)batch_index * m_outputStride), m_binCount + 1);
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::setMelFilterbank()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::setMelFilterbank(int band_count, T min_frequency, T max_frequency,
+								   int mfcc_count, bool log_energies)
+{
+	if(m_initialized || m_initializeFailed) {
+		return false;
+	}
+
+	if(band_count < 1 || min_frequency < 0 || max_frequency < 0
+			|| mfcc_count < 0 || mfcc_count > band_count || (mfcc_count > 0 && !log_energies)) {
+		return false;
+	}
+
+	m_melBandCount = band_count;
+	m_melMinFrequency = min_frequency;
+	m_melMaxFrequency = max_frequency;
+	m_mfccCount = mfcc_count;
+	m_melLog = log_energies;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getMelBands() / getMfcc()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::getMelBands(int batch_index, T *out) const
+{
+	const T		*src = this->_get_batch_post_process(batch_index);
+
+	if(src == nullptr || m_melBandCount == 0) {
+		return false;
+	}
+
+	::memcpy(out, &src[m_melOffset], (size_t)m_melBandCount * sizeof(T));
+	return true;
+}
+
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::getMfcc(int batch_index, T *out) const
+{
+	const T		*src = this->_get_batch_post_process(batch_index);
+
+	if(src == nullptr || m_mfccCount == 0) {
+		return false;
+	}
+
+	::memcpy(out, &src[m_mfccOffset], (size_t)m_mfccCount * sizeof(T));
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::setTargetFrequencies()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::setTargetFrequencies(const T *frequencies, int count)
+{
+	if(m_initialized || m_initializeFailed || count < 1) {
+		return false;
+	}
+
+	for(int i = 0; i < count; ++i) {
+		if(frequencies[i] < 0 || frequencies[i] > (T)m_sampleRate / (T)2.0) {
+			return false;
+		}
+	}
+
+	m_targetFrequencies.assign(frequencies, frequencies + count);
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_init_target_bins()
+ ***************************************************************/
+
+/*
+ * Rounds the target frequencies to fft bins and selects Goertzel or fft.  The
+ * Goertzel recurrence costs about 'frame_size' multiply-adds per target, the
+ * fft about 'padded_frame_size' * log2('padded_frame_size') for all bins.
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_init_target_bins()
+{
+	const int	count = (int)m_targetFrequencies.size();
+	double		w;
+
+	m_targetBins.resize(count);
+
+	for(int i = 0; i < count; ++i) {
+		m_targetBins[i] = std::min((int)std::lround(m_targetFrequencies[i] / m_frequencyStep), m_transformBinCount);
+	}
+
+	m_binCount = count - 1;
+	m_binFrequencies.resize(count);
+
+	for(int i = 0; i < count; ++i) {
+		m_binFrequencies[i] = (T)m_targetBins[i] * m_frequencyStep;
+	}
+
+	m_goertzel = ((double)count * m_frameSize)
+					<= GOERTZEL_BREAK_EVEN * m_paddedFrameSize * std::log2((double)m_paddedFrameSize);
+
+	m_goertzelCoeffs.resize(2 * count);
+	m_goertzelTwiddles.resize(2 * count);
+
+	for(int i = 0; i < count; ++i) {
+		w = 2.0 * M_PI * (double)m_targetBins[i] / (double)m_paddedFrameSize;
+
+		m_goertzelCoeffs[i] = std::cos(w);
+		m_goertzelCoeffs[count + i] = std::sin(w);
+		m_goertzelTwiddles[2 * i] = (T)std::cos(w * (m_frameSize - 1));
+		m_goertzelTwiddles[(2 * i) + 1] = (T)std::sin(w * (m_frameSize - 1));
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_goertzel_batch()
+ ***************************************************************/
+
+/*
+ * With the last two recurrence values s1 = s[M - 1] and s2 = s[M - 2]:
+ *		X(w) = e^(-jw(M - 1)) * (s1 - e^(-jw) * s2)
+ * which is the fft bin value, the zero padding contributes nothing.  The
+ * recurrence and s1 - e^(-jw) * s2, which cancels near w = 0 or pi, are
+ * computed in double precision.
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_goertzel_batch(const T *frame, T *complex_out) const
+{
+	const int	count = m_binCount + 1;
+	const T		*tw;
+	T			y_re;
+	T			y_im;
+
+	_goertzel(frame, m_frameSize, m_goertzelCoeffs.data(), &m_goertzelCoeffs[count], complex_out, count);
+
+	for(int i = 0; i < count; ++i) {
+		tw = &m_goertzelTwiddles[2 * i];
+		y_re = complex_out[2 * i];
+		y_im = complex_out[(2 * i) + 1];
+
+		complex_out[2 * i] = (tw[0] * y_re) + (tw[1] * y_im);
+		complex_out[(2 * i) + 1] = (tw[0] * y_im) - (tw[1] * y_re);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_gather_targets()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_gather_targets(const T *spectrum, T *complex_out) const
+{
+	for(int i = 0; i <= m_binCount; ++i) {
+		complex_out[2 * i] = spectrum[2 * m_targetBins[i]];
+		complex_out[(2 * i) + 1] = spectrum[(2 * m_targetBins[i]) + 1];
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::setZoom()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::setZoom(T start_frequency, T stop_frequency, int bin_count)
+{
+	if(m_initialized || m_initializeFailed || bin_count < 2) {
+		return false;
+	}
+
+	if(start_frequency < 0 || start_frequency >= stop_frequency || stop_frequency > (T)m_sampleRate / (T)2.0) {
+		return false;
+	}
+
+	m_zoomStart = start_frequency;
+	m_zoomStop = stop_frequency;
+	m_zoomBinCount = bin_count;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_init_zoom()
+ ***************************************************************/
+
+/*
+ * Bin 'k' of the band is the DTFT of the 'M' windowed samples at
+ * w0 + k * dw, writing n * k = (n^2 + k^2 - (k - n)^2) / 2:
+ *		X[k] = b[k] * sum(a[n] * x[n] * v[k - n])
+ *		a[n] = e^(-j(w0 * n + dw * n^2 / 2))
+ *		v[m] = e^(j * dw * m^2 / 2)
+ *		b[k] = e^(-j * dw * k^2 / 2)
+ * The sum is a linear convolution, computed as a circular one with ffts of a
+ * power of 2 length of at least 'M' + 'bin_count' - 1.  Chirp phases are
+ * computed in double precision and reduced modulo 2 pi, n^2 grows quickly.
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_init_zoom()
+{
+	const double	w0 = 2.0 * M_PI * (double)m_zoomStart / (double)m_sampleRate;
+	const double	dw = 2.0 * M_PI * ((double)m_zoomStop - (double)m_zoomStart)
+							/ ((double)(m_zoomBinCount - 1) * (double)m_sampleRate);
+	double			phase;
+
+	m_zoomLength = 1;
+	while(m_zoomLength < m_frameSize + m_zoomBinCount - 1) {
+		m_zoomLength *= 2;
+	}
+
+	m_zoomPreChirp.resize(2 * m_frameSize);
+	m_zoomPostChirp.resize(2 * m_zoomBinCount);
+
+	for(int n = 0; n < m_frameSize; ++n) {
+		phase = std::fmod((w0 * n) + (dw * 0.5 * (double)n * (double)n), 2.0 * M_PI);
+		m_zoomPreChirp[2 * n] = (T)std::cos(phase);
+		m_zoomPreChirp[(2 * n) + 1] = (T)-std::sin(phase);
+	}
+
+	m_binCount = m_zoomBinCount - 1;
+	m_binSpacing = (m_zoomStop - m_zoomStart) / (T)(m_zoomBinCount - 1);
+	m_binFrequencies.resize(m_zoomBinCount);
+
+	for(int k = 0; k < m_zoomBinCount; ++k) {
+		phase = std::fmod(dw * 0.5 * (double)k * (double)k, 2.0 * M_PI);
+		m_zoomPostChirp[2 * k] = (T)std::cos(phase);
+		m_zoomPostChirp[(2 * k) + 1] = (T)-std::sin(phase);
+		m_binFrequencies[k] = m_zoomStart + ((T)k * m_binSpacing);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_init_zoom_filter()
+ ***************************************************************/
+
+/*
+ * Fills the 'zoom_length' complex values of v[], wrapped for the circular
+ * convolution, with the 1 / 'zoom_length' of the backward transform folded in
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_init_zoom_filter(T *filter) const
+{
+	const double	dw = 2.0 * M_PI * ((double)m_zoomStop - (double)m_zoomStart)
+							/ ((double)(m_zoomBinCount - 1) * (double)m_sampleRate);
+	const double	scale = 1.0 / (double)m_zoomLength;
+	double			phase;
+	int				idx;
+
+	::memset(filter, 0, (size_t)2 * m_zoomLength * sizeof(T));
+
+	for(int m = -(m_frameSize - 1); m < m_zoomBinCount; ++m) {
+		phase = std::fmod(dw * 0.5 * (double)m * (double)m, 2.0 * M_PI);
+		idx = (m < 0) ? m + m_zoomLength : m;
+
+		filter[2 * idx] = (T)(std::cos(phase) * scale);
+		filter[(2 * idx) + 1] = (T)(std::sin(phase) * scale);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_zoom_premultiply() / _zoom_convolve() / _zoom_postmultiply()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_zoom_premultiply(const T *frame, T *work) const
+{
+	for(int n = 0; n < m_frameSize; ++n) {
+		work[2 * n] = frame[n] * m_zoomPreChirp[2 * n];
+		work[(2 * n) + 1] = frame[n] * m_zoomPreChirp[(2 * n) + 1];
+	}
+
+	::memset(&work[2 * m_frameSize], 0, (size_t)2 * (m_zoomLength - m_frameSize) * sizeof(T));
+}
+
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_zoom_convolve(T *work, const T *filter) const
+{
+	_complex_multiply(work, filter, work, m_zoomLength);
+}
+
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_zoom_postmultiply(const T *work, T *complex_out) const
+{
+	_complex_multiply(work, m_zoomPostChirp.data(), complex_out, m_zoomBinCount);
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::setPeakDetection()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::setPeakDetection(int max_peaks, T min_level)
+{
+	if(m_initialized || m_initializeFailed || max_peaks < 1) {
+		return false;
+	}
+
+	m_peakMaxCount = max_peaks;
+	m_peakMinLevel = min_level;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getPeaks()
+ ***************************************************************/
+
+template<typename T>
+int
+FFTAudioBaseT<T>::getPeaks(int batch_index, int count, T min_level, fftaPeakT<T> *out) const
+{
+	const T		*src = this->_get_batch_post_process(batch_index);
+	int			found;
+	int			ret = 0;
+
+	if(src == nullptr || m_peakMaxCount == 0) {
+		return -1;
+	}
+
+	src = &src[m_peakOffset];
+	found = (int)src[0];
+
+	if(count > found) {
+		count = found;
+	}
+
+	/*
+	 * Peaks are stored strongest first, stop at the first one below 'min_level'
+	 */
+	for(; ret < count; ++ret) {
+		const T		*peak = &src[1 + (3 * ret)];
+
+		if(peak[1] < min_level) {
+			break;
+		}
+
+		out[ret].frequency = peak[0];
+		out[ret].amplitude = peak[1];
+		out[ret].bin = (int)peak[2];
+	}
+
+	return ret;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::setAveraging()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::setAveraging(fftaAverageMode mode, T alpha)
+{
+	if(m_initialized || m_initializeFailed) {
+		return false;
+	}
+
+	if(mode == FFTA_AVERAGE_EXPONENTIAL && (alpha <= 0 || alpha > 1)) {
+		return false;
+	}
+
+	m_averageMode = mode;
+	m_averageAlpha = (mode == FFTA_AVERAGE_EXPONENTIAL) ? alpha : (T)0;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getAverage()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::getAverage(T *out, int first_bin, int count) const
+{
+	if(!m_initialized || m_averageMode == FFTA_AVERAGE_NONE
+			|| first_bin < 0 || count < 0 || first_bin + count > m_binCount + 1) {
+		return false;
+	}
+
+	::memcpy(out, &m_averageState[first_bin], (size_t)count * sizeof(T));
+
+	if(m_averageCorrection != 1) {
+		_affine(out, count, m_averageCorrection, (T)0);
+	}
+
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::resetAverage()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::resetAverage()
+{
+	std::fill(m_averageState.begin(), m_averageState.end(), (T)0);
+	m_averageFrames = 0;
+	m_averageCorrection = 1;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_get_average_stride()
+ ***************************************************************/
+
+template<typename T>
+int
+FFTAudioBaseT<T>::_get_average_stride() const
+{
+	const int	line = ((m_sliceAlignment > AVERAGE_ALIGNMENT) ? m_sliceAlignment : AVERAGE_ALIGNMENT) / (int)sizeof(T);
+
+	return ((m_binCount + 1 + line - 1) / line) * line;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_set_slice_alignment() / FFTAudioBaseT::_align_slice()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_set_slice_alignment(int bytes)
+{
+	m_sliceAlignment = bytes;
+}
+
+
+/*
+ * Returns 'count' values of 'value_size' bytes, rounded up to a whole number of
+ * slice alignment units
+ */
+template<typename T>
+int
+FFTAudioBaseT<T>::_align_slice(int count, size_t value_size) const
+{
+	int		unit;
+
+	if(m_sliceAlignment == 0) {
+		return count;
+	}
+
+	unit = m_sliceAlignment / (int)value_size;
+	return ((count + unit - 1) / unit) * unit;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_accumulate_average()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_accumulate_average(const T *complex_in, int batch_index, T *accumulator) const
+{
+	if(m_averageMode == FFTA_AVERAGE_PEAK_HOLD) {
+		_peak_power(complex_in, accumulator, m_binCount + 1, m_averageWeights[batch_index]);
+	}
+	else {
+		_accumulate_power(complex_in, accumulator, m_binCount + 1, m_averageWeights[batch_index]);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_reduce_average()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_reduce_average(T *accumulators, int accumulator_count, int first_bin, int count)
+{
+	const int	stride = this->_get_average_stride();
+	T			*state = &m_averageState[first_bin];
+	T			*acc;
+
+	switch(m_averageMode) {
+	case FFTA_AVERAGE_LINEAR:
+		::memset(state, 0, (size_t)count * sizeof(T));
+		break;
+
+	case FFTA_AVERAGE_EXPONENTIAL:
+		_affine(state, count, m_averageDecay, (T)0);
+		break;
+
+	default:
+		break;
+	}
+
+	for(int i = 0; i < accumulator_count; ++i) {
+		acc = &accumulators[((size_t)stride * i) + first_bin];
+
+		if(m_averageMode == FFTA_AVERAGE_PEAK_HOLD) {
+			_element_maximum(state, acc, count);
+		}
+		else {
+			_add(state, acc, count);
+		}
+
+		::memset(acc, 0, (size_t)count * sizeof(T));
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_finish_average()
+ ***************************************************************/
+
+/*
+ * The exponential average starts from zero, after 'n' spectra its weights sum
+ * to 1 - (1 - alpha)^n, readout divides that back out
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_finish_average()
+{
+	m_averageFrames += m_batchCount;
+
+	if(m_averageMode == FFTA_AVERAGE_EXPONENTIAL) {
+		m_averageCorrection = (T)(1.0 / (1.0 - std::pow(1.0 - (double)m_averageAlpha, (double)m_averageFrames)));
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_post_process_batch()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::_post_process_batch(const T *complex_in, T *out) const
+{
+	if(!m_spectrumStages.empty()) {
+		this->_process_spectrum(complex_in, &out[m_spectrumOffset],
+								(m_spectrumScratchOffset < 0) ? nullptr : &out[m_spectrumScratchOffset]);
+	}
+
+	if(m_peakMaxCount > 0) {
+		this->_find_peaks(complex_in, &out[m_peakOffset], &out[m_peakScratchOffset]);
+	}
+
+	/*
+	 * Power of the normalized magnitude, (2 * |X| / window_sum)^2
+	 */
+	const T		power_scale = ((T)2.0 / m_windowSum) * ((T)2.0 / m_windowSum);
+	T			*mel;
+	T			*mfcc;
+
+	if(m_melBandCount > 0) {
+		mel = &out[m_melOffset];
+
+		for(int b = 0; b < m_melBandCount; ++b) {
+			mel[b] = _weighted_power(&complex_in[2 * m_melFirstBin[b]], &m_melWeights[m_melWeightIndex[b]],
+									 m_melBinCount[b]) * power_scale;
+		}
+
+		if(m_melLog) {
+			for(int b = 0; b < m_melBandCount; ++b) {
+				mel[b] = std::log(std::max(mel[b], (T)MEL_LOG_FLOOR));
+			}
+		}
+
+		/*
+		 * DCT-II of the log band energies
+		 */
+		mfcc = &out[m_mfccOffset];
+
+		for(int k = 0; k < m_mfccCount; ++k) {
+			const T		*row = &m_dctMatrix[k * m_melBandCount];
+			T			sum = 0;
+
+			for(int b = 0; b < m_melBandCount; ++b) {
+				sum += row[b] * mel[b];
+			}
+
+			mfcc[k] = sum;
+		}
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::addSpectrumStage()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::addSpectrumStage(fftaSpectrumStage stage, T param1, T param2)
+{
+	spectrumStage	entry;
+
+	if(m_initialized || m_initializeFailed) {
+		return false;
+	}
+
+	entry.ssm_stage = stage;
+	entry.ssm_param1 = param1;
+	entry.ssm_param2 = param2;
+	entry.ssm_domain = m_spectrumDomain;
+
+	switch(stage) {
+	case FFTA_STAGE_POWER:
+		if(m_spectrumDomain != spectrumStage::DOMAIN_AMPLITUDE) {
+			return false;
+		}
+
+		m_spectrumDomain = spectrumStage::DOMAIN_POWER;
+		break;
+
+	case FFTA_STAGE_DB:
+		if(m_spectrumDomain == spectrumStage::DOMAIN_DB || param1 < 0) {
+			return false;
+		}
+
+		if(param1 == 0) {
+			entry.ssm_param1 = (T)1.0;
+		}
+
+		m_spectrumDomain = spectrumStage::DOMAIN_DB;
+		break;
+
+	case FFTA_STAGE_A_WEIGHTING:
+	case FFTA_STAGE_C_WEIGHTING:
+	case FFTA_STAGE_NORMALIZE:
+		break;
+
+	case FFTA_STAGE_SMOOTH:
+		if(param1 < 1) {
+			return false;
+		}
+
+		break;
+
+	case FFTA_STAGE_CLAMP:
+		if(param1 > param2) {
+			return false;
+		}
+
+		break;
+
+	default:
+		return false;
+	}
+
+	m_spectrumStages.push_back(entry);
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getSpectrum()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::getSpectrum(int batch_index, T *out, int first_bin, int count) const
+{
+	const T		*src = this->_get_batch_post_process(batch_index);
+
+	if(src == nullptr || m_spectrumStages.empty()
+			|| first_bin < 0 || count < 0 || first_bin + count > m_binCount + 1) {
+		return false;
+	}
+
+	::memcpy(out, &src[m_spectrumOffset + first_bin], (size_t)count * sizeof(T));
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_init_spectrum_stages()
+ ***************************************************************/
+
+/*
+ * Builds the per-bin gain tables of the weighting stages, IEC 61672:
+ *		Ra(f) = 12194^2 * f^4 / ((f^2 + 20.6^2) * sqrt((f^2 + 107.7^2) * (f^2 + 737.9^2)) * (f^2 + 12194^2))
+ *		Rc(f) = 12194^2 * f^2 / ((f^2 + 20.6^2) * (f^2 + 12194^2))
+ * normalized to 0 dB at 1 khz (+2.00 dB and +0.06 dB)
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_init_spectrum_stages()
+{
+	double		f2;
+	double		gain;
+
+	for(size_t i = 0; i < m_spectrumStages.size(); ++i) {
+		spectrumStage	&stage = m_spectrumStages[i];
+
+		if(stage.ssm_stage != FFTA_STAGE_A_WEIGHTING && stage.ssm_stage != FFTA_STAGE_C_WEIGHTING) {
+			continue;
+		}
+
+		stage.ssm_table.resize(m_binCount + 1);
+
+		for(int k = 0; k <= m_binCount; ++k) {
+			f2 = (double)this->getBinFrequency(k);
+			f2 *= f2;
+
+			if(stage.ssm_stage == FFTA_STAGE_A_WEIGHTING) {
+				gain = (12194.0 * 12194.0 * f2 * f2)
+							/ ((f2 + (20.6 * 20.6)) * ::sqrt((f2 + (107.7 * 107.7)) * (f2 + (737.9 * 737.9))) * (f2 + (12194.0 * 12194.0)));
+				gain *= ::pow(10.0, 2.00 / 20.0);
+			}
+			else {
+				gain = (12194.0 * 12194.0 * f2) / ((f2 + (20.6 * 20.6)) * (f2 + (12194.0 * 12194.0)));
+				gain *= ::pow(10.0, 0.06 / 20.0);
+			}
+
+			switch(stage.ssm_domain) {
+			case spectrumStage::DOMAIN_POWER:
+				gain *= gain;
+				break;
+
+			case spectrumStage::DOMAIN_DB:
+				gain = 20.0 * ::log10(std::max(gain, 1e-10));
+				break;
+			}
+
+			stage.ssm_table[k] = (T)gain;
+		}
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_process_spectrum()
+ ***************************************************************/
+
+/*
+ * Computes the amplitudes of one batch into 'spectrum' and runs the pipeline
+ * stages over them.  'scratch' holds 'bin_count' + 1 values for smoothing.
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_process_spectrum(const T *complex_in, T *spectrum, T *scratch) const
+{
+	const int	count = m_binCount + 1;
+	T			peak;
+	T			sum;
+	int			width;
+	int			lo;
+	int			hi;
+
+	_magnitude(complex_in, spectrum, count, (T)2.0 / m_windowSum);
+
+	for(size_t i = 0; i < m_spectrumStages.size(); ++i) {
+		const spectrumStage	&stage = m_spectrumStages[i];
+
+		switch(stage.ssm_stage) {
+		case FFTA_STAGE_POWER:
+			_multiply(spectrum, spectrum, count);
+			break;
+
+		case FFTA_STAGE_DB:
+			if(stage.ssm_domain == spectrumStage::DOMAIN_POWER) {
+				_log_scale(spectrum, count, (T)10.0);
+				_affine(spectrum, count, (T)1.0, (T)-10.0 * std::log10(stage.ssm_param1));
+			}
+			else {
+				_log_scale(spectrum, count, (T)20.0);
+				_affine(spectrum, count, (T)1.0, (T)-20.0 * std::log10(stage.ssm_param1));
+			}
+
+			break;
+
+		case FFTA_STAGE_A_WEIGHTING:
+		case FFTA_STAGE_C_WEIGHTING:
+			if(stage.ssm_domain == spectrumStage::DOMAIN_DB) {
+				_add(spectrum, stage.ssm_table.data(), count);
+			}
+			else {
+				_multiply(spectrum, stage.ssm_table.data(), count);
+			}
+
+			break;
+
+		case FFTA_STAGE_SMOOTH:
+			/*
+			 * Running sum over the window, which shrinks at the edges
+			 */
+			::memcpy(scratch, spectrum, (size_t)count * sizeof(T));
+
+			width = (int)stage.ssm_param1;
+			sum = 0;
+			lo = 0;
+			hi = 0;
+
+			for(int k = 0; k < count; ++k) {
+				while(hi < count && hi <= k + width) {
+					sum += scratch[hi++];
+				}
+
+				while(lo < k - width) {
+					sum -= scratch[lo++];
+				}
+
+				spectrum[k] = sum / (T)(hi - lo);
+			}
+
+			break;
+
+		case FFTA_STAGE_CLAMP:
+			_clamp(spectrum, count, stage.ssm_param1, stage.ssm_param2);
+			break;
+
+		case FFTA_STAGE_NORMALIZE:
+			peak = _maximum(spectrum, count);
+
+			if(stage.ssm_domain == spectrumStage::DOMAIN_DB) {
+				_affine(spectrum, count, (T)1.0, -peak);
+			}
+			else if(peak > 0) {
+				_affine(spectrum, count, (T)1.0 / peak, (T)0);
+			}
+
+			break;
+		}
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_find_peaks()
+ ***************************************************************/
+
+/*
+ * Finds the 'max_peaks' strongest local maxima of one batch.  'peaks' receives
+ * the peak count and the (frequency, amplitude, bin) triplets, 'amplitudes'
+ * is scratch space for the 'bin_count' + 1 bin amplitudes.
+ *
+ * Each local maximum is interpolated first, so the minimum level and the
+ * strongest-first order apply to the interpolated amplitude.  Candidates are
+ * kept in a list sorted strongest first, so each one costs one compare
+ * against the weakest kept peak and only stronger ones are inserted.
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_find_peaks(const T *complex_in, T *peaks, T *amplitudes) const
+{
+	T			*list = &peaks[1];
+	int			found = 0;
+	int			pos;
+	T			a;
+	T			b;
+	T			c;
+	T			offset;
+	T			denom;
+	T			level;
+
+	_magnitude(complex_in, amplitudes, m_binCount + 1, (T)2.0 / m_windowSum);
+
+	/*
+	 * Local maxima, the edge bins have no neighbour to interpolate with
+	 */
+	for(int k = 1; k < m_binCount; ++k) {
+		level = amplitudes[k];
+
+		if(level <= amplitudes[k - 1] || level < amplitudes[k + 1]) {
+			continue;
+		}
+
+		/*
+		 * Parabolic interpolation of the log amplitudes of the peak bin and its
+		 * neighbours, the vertex gives the sub-bin offset and the peak amplitude
+		 */
+		offset = 0;
+
+		if(amplitudes[k - 1] > 0 && amplitudes[k + 1] > 0) {
+			a = std::log(amplitudes[k - 1]);
+			b = std::log(level);
+			c = std::log(amplitudes[k + 1]);
+			denom = a - (2 * b) + c;
+
+			if(denom < 0) {
+				offset = (T)0.5 * (a - c) / denom;
+				level = std::exp(b - ((T)0.25 * (a - c) * offset));
+			}
+		}
+
+		if(level < m_peakMinLevel) {
+			continue;
+		}
+
+		if(found == m_peakMaxCount) {
+			if(level <= list[(3 * (found - 1)) + 1]) {
+				continue;
+			}
+
+			--found;
+		}
+
+		for(pos = found; pos > 0 && list[(3 * (pos - 1)) + 1] < level; --pos) {
+			list[3 * pos] = list[3 * (pos - 1)];
+			list[(3 * pos) + 1] = list[(3 * (pos - 1)) + 1];
+			list[(3 * pos) + 2] = list[(3 * (pos - 1)) + 2];
+		}
+
+		list[3 * pos] = this->getBinFrequency(k) + (offset * m_binSpacing);
+		list[(3 * pos) + 1] = level;
+		list[(3 * pos) + 2] = (T)k;
+		++found;
+	}
+
+	peaks[0] = (T)found;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_init_mel_filterbank()
+ ***************************************************************/
+
+/*
+ * Builds the sparse triangular filter matrix and the DCT-II matrix, band
+ * edges are spaced evenly on the mel scale, mel = 2595 * log10(1 + hz / 700)
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_init_mel_filterbank()
+{
+	std::vector<T>	edges(m_melBandCount + 2);
+	T				mel_min = (T)2595.0 * std::log10((T)1.0 + m_melMinFrequency / (T)700.0);
+	T				mel_max = (T)2595.0 * std::log10((T)1.0 + m_melMaxFrequency / (T)700.0);
+	T				mel;
+	T				freq;
+	T				weight;
+
+	for(int i = 0; i < m_melBandCount + 2; ++i) {
+		mel = mel_min + ((mel_max - mel_min) * (T)i / (T)(m_melBandCount + 1));
+		edges[i] = (T)700.0 * (std::pow((T)10.0, mel / (T)2595.0) - (T)1.0);
+	}
+
+	m_melFirstBin.assign(m_melBandCount, 0);
+	m_melBinCount.assign(m_melBandCount, 0);
+	m_melWeightIndex.assign(m_melBandCount, 0);
+	m_melWeights.clear();
+
+	for(int b = 0; b < m_melBandCount; ++b) {
+		m_melWeightIndex[b] = (int)m_melWeights.size();
+
+		for(int k = 0; k <= m_binCount; ++k) {
+			freq = this->getBinFrequency(k);
+
+			if(freq <= edges[b] || freq >= edges[b + 2]) {
+				continue;
+			}
+
+			if(freq <= edges[b + 1]) {
+				weight = (freq - edges[b]) / (edges[b + 1] - edges[b]);
+			}
+			else {
+				weight = (edges[b + 2] - freq) / (edges[b + 2] - edges[b + 1]);
+			}
+
+			if(m_melBinCount[b] == 0) {
+				m_melFirstBin[b] = k;
+			}
+
+			m_melWeights.push_back(weight);
+			m_melBinCount[b]++;
+		}
+	}
+
+	/*
+	 * Orthonormal DCT-II
+	 */
+	m_dctMatrix.assign((size_t)m_mfccCount * m_melBandCount, 0);
+
+	for(int k = 0; k < m_mfccCount; ++k) {
+		T	norm = std::sqrt(((k == 0) ? (T)1.0 : (T)2.0) / (T)m_melBandCount);
+
+		for(int b = 0; b < m_melBandCount; ++b) {
+			m_dctMatrix[(k * m_melBandCount) + b] = norm * std::cos((T)M_PI * (T)k * ((T)b + (T)0.5) / (T)m_melBandCount);
+		}
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_get_batch_post_process()
+ ***************************************************************/
+
+/*
+ * Returns the output stage values of 'batch_index', or nullptr if invalid
+ */
+template<typename T>
+const T *
+FFTAudioBaseT<T>::_get_batch_post_process(int batch_index) const
+{
+	if(!m_initialized || m_postProcessSize == 0 || batch_index < 0 || batch_index >= m_batchCount) {
+		return nullptr;
+	}
+
+	return &this->_get_post_process_buffer()[(size_t)batch_index * m_postProcessStride];
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::setStatsEnabled()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::setStatsEnabled(bool enable)
+{
+	if(m_initialized || m_initializeFailed) {
+		return false;
+	}
+
+	m_statsEnabled = enable;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::getStats()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioBaseT<T>::getStats(fftaStats &stats) const
+{
+	if(!m_initialized || m_statsCounters == nullptr) {
+		return false;
+	}
+
+	stats.batches = m_statsBatches.load(std::memory_order_relaxed);
+	stats.latencyTotalNs = m_statsLatencyTotal.load(std::memory_order_relaxed);
+	stats.latencyMaxNs = m_statsLatencyMax.load(std::memory_order_relaxed);
+
+	for(int i = 0; i < fftaStats::LATENCY_BUCKETS; ++i) {
+		stats.latencyHistogram[i] = m_statsLatencyHistogram[i].load(std::memory_order_relaxed);
+	}
+
+	for(int s = 0; s < FFTA_STATS_STAGE_COUNT; ++s) {
+		stats.stageNs[s] = 0;
+		stats.stageCalls[s] = 0;
+
+		for(int i = 0; i <= m_statsThreadCount; ++i) {
+			stats.stageNs[s] += m_statsCounters[i].scm_stageNs[s].load(std::memory_order_relaxed);
+			stats.stageCalls[s] += m_statsCounters[i].scm_stageCalls[s].load(std::memory_order_relaxed);
+		}
+	}
+
+	stats.workers.resize(m_statsThreadCount);
+
+	for(int i = 0; i < m_statsThreadCount; ++i) {
+		stats.workers[i].busyNs = m_statsCounters[i].scm_busyNs.load(std::memory_order_relaxed);
+		stats.workers[i].idleNs = m_statsCounters[i].scm_idleNs.load(std::memory_order_relaxed);
+		stats.workers[i].items = m_statsCounters[i].scm_items.load(std::memory_order_relaxed);
+	}
+
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::resetStats()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioBaseT<T>::resetStats()
+{
+	if(m_statsCounters == nullptr) {
+		return;
+	}
+
+	for(int i = 0; i <= m_statsThreadCount; ++i) {
+		for(int s = 0; s < FFTA_STATS_STAGE_COUNT; ++s) {
+			m_statsCounters[i].scm_stageNs[s].store(0, std::memory_order_relaxed);
+			m_statsCounters[i].scm_stageCalls[s].store(0, std::memory_order_relaxed);
+		}
+
+		m_statsCounters[i].scm_busyNs.store(0, std::memory_order_relaxed);
+		m_statsCounters[i].scm_idleNs.store(0, std::memory_order_relaxed);
+		m_statsCounters[i].scm_items.store(0, std::memory_order_relaxed);
+	}
+
+	m_statsBatches.store(0, std::memory_order_relaxed);
+	m_statsLatencyTotal.store(0, std::memory_order_relaxed);
+	m_statsLatencyMax.store(0, std::memory_order_relaxed);
+
+	for(int i = 0; i < fftaStats::LATENCY_BUCKETS; ++i) {
+		m_statsLatencyHistogram[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_init_stats()
+ ***************************************************************/
+
+/*
+ * Allocates the counters if setStatsEnabled() was called, 'thread_count'
+ * worker slots plus the batch thread's slot
+ */
+template<typename T>
+fftaStatus
+FFTAudioBaseT<T>::_init_stats(int thread_count)
+{
+	void	*mem;
+
+	if(!m_statsEnabled) {
+		return FFTA_SUCCESS;
+	}
+
+	if(::posix_memalign(&mem, AVERAGE_ALIGNMENT, sizeof(statsCounters) * (thread_count + 1)) != 0) {
+		return FFTA_ALLOC_FAILED;
+	}
+
+	m_statsCounters = (statsCounters *)mem;
+	m_statsThreadCount = thread_count;
+
+	for(int i = 0; i <= thread_count; ++i) {
+		new(&m_statsCounters[i]) statsCounters();
+	}
+
+	this->resetStats();
+	return FFTA_SUCCESS;
+}
+
+
+/***************************************************************
+ * FFTAudioBaseT::_stats_add_batch()
+ ***************************************************************/
+
+/*
+ * Records the latency of one batch, called by the thread running it
+ */
+template<typename T>
+void
+FFTAudioBaseT<T>::_stats_add_batch(uint64_t latency_ns)
+{
+	int		bucket = 63 - __builtin_clzll(latency_ns | 1);
+
+	if(bucket >= fftaStats::LATENCY_BUCKETS) {
+		bucket = fftaStats::LATENCY_BUCKETS - 1;
+	}
+
+	_stats_add(m_statsBatches, 1);
+	_stats_add(m_statsLatencyTotal, latency_ns);
+	_stats_add(m_statsLatencyHistogram[bucket], 1);
+
+	if(latency_ns > m_statsLatencyMax.load(std::memory_order_relaxed)) {
+		m_statsLatencyMax.store(latency_ns, std::memory_order_relaxed);
+	}
+}
+
+
+/***************************************************************
+ * Explicit instantiations
+ ***************************************************************/
+
+template class FFTAudioBaseT<float>;
+template class FFTAudioBaseT<double>;
+
+
+/***************************************************************
+ * fftaAllocCheck
+ ***************************************************************/
+
+thread_local int			fftaAllocCheck::sm_depth = 0;
+std::atomic<uint64_t>		fftaAllocCheck::sm_violations(0);
+
+
+/*
+ * The scope depth is cleared while reporting, so an allocation made by the
+ * report itself isn't reported again
+ */
+void
+fftaAllocCheck::report(size_t size)
+{
+	int		depth = sm_depth;
+
+	sm_depth = 0;
+	sm_violations.fetch_add(1);
+	::fprintf(stderr, "fftaudio: %zu byte allocation inside execute()\n", size);
+	sm_depth = depth;
+}
+
+
+#ifdef FFTA_RT_ALLOC_CHECK
+
+/*
+ * Replacement global allocation functions
+ */
+static void *
+alloc_checked(size_t size)
+{
+	void	*ptr;
+
+	if(fftaAllocCheck::isActive()) {
+		fftaAllocCheck::report(size);
+	}
+
+	ptr = ::malloc((size == 0) ? 1 : size);
+	if(ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	return ptr;
+}
+
+void *operator new(size_t size)								{ return alloc_checked(size);		}
+void *operator new[](size_t size)							{ return alloc_checked(size);		}
+void operator delete(void *ptr) noexcept					{ ::free(ptr);						}
+void operator delete[](void *ptr) noexcept					{ ::free(ptr);						}
+void operator delete(void *ptr, size_t) noexcept			{ ::free(ptr);						}
+void operator delete[](void *ptr, size_t) noexcept			{ ::free(ptr);						}
+
+void *
+operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	try {
+		return alloc_checked(size);
+	}
+	catch(...) {
+		return nullptr;
+	}
+}
+
+void *
+operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+	try {
+		return alloc_checked(size);
+	}
+	catch(...) {
+		return nullptr;
+	}
+}
+
+#endif // FFTA_RT_ALLOC_CHECK
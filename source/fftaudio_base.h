@@ -19,39 +19,279 @@
 #define FFTA__BASE__H__
 
 
+#include	<atomic>
+#include	<cstddef>
+#include	<cstdint>
+#include	<ctime>
+#include	<utility>
+#include	<vector>
 #include	<values.h>
+#include	<pthread.h>
 #include	<fftaudio_status.h>
 
 
-class FFTAudioBase
+//
+// Packed signed 24-bit little-endian sample, for use with execute()
+//
+struct fftaInt24
+{
+	uint8_t		bytes[3];
+};
+
+
+//
+// Spectrum pipeline stages, for use with addSpectrumStage().  The pipeline
+// starts with the bin amplitudes getBinValue() returns (before its callback),
+// each stage applies to the output of the previous one.
+//
+typedef enum ffta_spectrum_stage_enum {
+	// Amplitude to power (squares each value), not allowed after
+	// FFTA_STAGE_POWER or FFTA_STAGE_DB
+	FFTA_STAGE_POWER = 0,
+
+	// Convert to decibels relative to 'param1' (0 selects 1.0), 20 * log10
+	// for amplitudes and 10 * log10 for power, not allowed after FFTA_STAGE_DB
+	FFTA_STAGE_DB,
+
+	// IEC 61672 A or C frequency weighting, applied as a gain in the current
+	// domain (amplitude, power or decibels)
+	FFTA_STAGE_A_WEIGHTING,
+	FFTA_STAGE_C_WEIGHTING,
+
+	// Moving average over 'param1' bins on each side
+	FFTA_STAGE_SMOOTH,
+
+	// Limit values to the range 'param1' --> 'param2'
+	FFTA_STAGE_CLAMP,
+
+	// Scale so the largest value of each spectrum is 1.0 (0 dB in decibels)
+	FFTA_STAGE_NORMALIZE
+} fftaSpectrumStage;
+
+
+//
+// Spectral peak, for use with getPeaks()
+//
+template<typename T>
+struct fftaPeakT
+{
+	T			frequency;		// interpolated frequency, in hz
+	T			amplitude;		// interpolated amplitude, same scale as getBinValue()
+	int			bin;			// index of the bin holding the peak
+};
+
+typedef fftaPeakT<float>	fftaPeak;
+typedef fftaPeakT<double>	fftaPeakDouble;
+
+
+//
+// Read-only view of the complex spectrum of one batch, for use with
+// getComplexSpectrum().  'size()' complex values stored as interleaved (real,
+// imaginary) pairs, begin() --> end() covers the 2 * 'size()' values.
+//
+template<typename T>
+class fftaComplexViewT
+{
+public:
+	fftaComplexViewT() = default;
+
+	fftaComplexViewT(const T *data, int size) :
+		m_data(data),
+		m_size(size)
+	{
+	}
+
+	const T *data() const							{ return m_data;						}
+	int size() const								{ return m_size;						}
+	bool empty() const								{ return m_size == 0;					}
+	T real(int bin) const							{ return m_data[2 * bin];				}
+	T imag(int bin) const							{ return m_data[(2 * bin) + 1];			}
+	const T *begin() const							{ return m_data;						}
+	const T *end() const							{ return m_data + (2 * m_size);			}
+
+private:
+	const T		*m_data = nullptr;
+	int			m_size = 0;
+};
+
+typedef fftaComplexViewT<float>		fftaComplexView;
+typedef fftaComplexViewT<double>	fftaComplexViewDouble;
+
+
+//
+// Spectrum averaging modes, for use with setAveraging().  Averages are
+// computed on the bin power, the square of getBinValue() before its callback.
+//
+typedef enum ffta_average_mode_enum {
+	// No averaging (default)
+	FFTA_AVERAGE_NONE = 0,
+
+	// Mean of the 'batch_count' spectra of each execute()
+	FFTA_AVERAGE_LINEAR,
+
+	// Exponential moving average over every spectrum, in batch order and
+	// across calls, avg = alpha * power + (1 - alpha) * avg
+	FFTA_AVERAGE_EXPONENTIAL,
+
+	// Maximum of every spectrum since initialize() or resetAverage()
+	FFTA_AVERAGE_PEAK_HOLD
+} fftaAverageMode;
+
+
+//
+// Execution stages timed when statistics are enabled, see fftaStats
+//
+typedef enum ffta_stats_stage_enum {
+	// Sample conversion and windowing
+	FFTA_STATS_CONVERT = 0,
+
+	// fft, chirp-z or Goertzel evaluation, including device transfers
+	FFTA_STATS_TRANSFORM,
+
+	// Target gathering, output stages and average accumulation
+	FFTA_STATS_POST_PROCESS,
+
+	// Merging the per-thread averages
+	FFTA_STATS_REDUCE,
+
+	// Thread running the batch waiting for the worker threads
+	FFTA_STATS_WAIT,
+
+	FFTA_STATS_STAGE_COUNT
+} fftaStatsStage;
+
+
+//
+// Busy and idle time of one worker thread, see fftaStats
+//
+struct fftaWorkerStats
+{
+	uint64_t	busyNs;			// time spent running jobs
+	uint64_t	idleNs;			// time spent waiting for a job
+	uint64_t	items;			// work items (batches, reduce ranges) processed
+};
+
+
+//
+// Execution statistics, for use with getStats().  Times are in nanoseconds,
+// cumulative since initialize() or resetStats().
+//
+struct fftaStats
+{
+	static const int LATENCY_BUCKETS = 32;
+
+	uint64_t	batches;							// batches completed
+	uint64_t	stageNs[FFTA_STATS_STAGE_COUNT];	// time per fftaStatsStage, all threads
+	uint64_t	stageCalls[FFTA_STATS_STAGE_COUNT];	// calls per fftaStatsStage, all threads
+
+	// Batch latency, from the start of processing to results ready.  Bucket
+	// 'i' counts batches that took 2^i --> 2^(i + 1) - 1 ns, the last
+	// bucket also counts every longer batch.
+	uint64_t	latencyTotalNs;
+	uint64_t	latencyMaxNs;
+	uint64_t	latencyHistogram[LATENCY_BUCKETS];
+
+	std::vector<fftaWorkerStats>	workers;
+};
+
+
+//
+// Debug check for memory allocation in the execute() hot path.  When the
+// library is built with FFTA_RT_ALLOC_CHECK defined (make RT_ALLOC_CHECK=1),
+// global operator new reports each allocation a thread makes while inside an
+// fftaAllocCheck scope to stderr and counts it.  The library opens a scope
+// around the work of every batch.
+//
+class fftaAllocCheck
+{
+public:
+	fftaAllocCheck()								{ ++sm_depth;							}
+	~fftaAllocCheck()								{ --sm_depth;							}
+
+	static bool isActive()							{ return sm_depth > 0;					}
+
+	/*
+	 * Returns the number of allocations made inside a scope, always 0
+	 * unless built with FFTA_RT_ALLOC_CHECK
+	 */
+	static uint64_t getViolationCount()				{ return sm_violations.load();			}
+
+	/*
+	 * Counts and reports an allocation of 'size' bytes, called by operator new
+	 */
+	static void report(size_t size);
+
+private:
+	static thread_local int			sm_depth;
+	static std::atomic<uint64_t>	sm_violations;
+};
+
+#ifdef FFTA_RT_ALLOC_CHECK
+#define FFTA_ALLOC_CHECK_SCOPE()		fftaAllocCheck	ffta_alloc_check_scope
+#else
+#define FFTA_ALLOC_CHECK_SCOPE()
+#endif
+
+
+//
+// Common implementation of all api's, 'T' is the floating point type used for
+// window tables, fft input and results (float or double)
+//
+template<typename T>
+class FFTAudioBaseT
 {
 public:
 	/*
 	 * FuncInitWindowCB Type
 	 *
 	 * Callback function type for fft window functions
-	 *	  void window_func(int frame_size, float &window_sum, float *output)
+	 *	  void window_func(int frame_size, T &window_sum, T *output)
 	 *		frame_size - size of unpadded fft frame, in samples
 	 *		window_sum - sum of frame sample multipliers
 	 *		output - array of 'frame_size' containing frame sample multipliers
 	 */
-	typedef	void (*FuncInitWindowCB)(int, float &, float *);
+	typedef	void (*FuncInitWindowCB)(int, T &, T *);
 
 	/*
 	 * FuncGetBinCB Type
 	 *
 	 * Callback function type for post-processing bin results.  Called whenever
 	 * getBinValue() is called to allow modification of raw result.
-	 *		void get_bin_cb(int bin_index, float &bin_value)
+	 *		void get_bin_cb(int bin_index, T &bin_value, void *user_ptr)
 	 *			bin_index - index of bin (0 --> 'padded_frame_size' / 2)
 	 *			bin_value - input/output of bin result value
 	 *			user_ptr - user pointer associated with callback
 	 */
-	typedef	void (*FuncGetBinCB)(int, float &, void *);
+	typedef	void (*FuncGetBinCB)(int, T &, void *);
+
+	/*
+	 * FuncGetBinsCB Type
+	 *
+	 * Callback function type for post-processing a block of bin results.  Called
+	 * once per spectrum whenever getBinValues() or getAllBinValues() is called.
+	 *		void get_bins_cb(int batch_index, int first_bin, int count, T *values, void *user_ptr)
+	 *			batch_index - index of batch the values belong to
+	 *			first_bin - index of the bin stored in values[0]
+	 *			count - number of bin values
+	 *			values - input/output array of 'count' bin result values
+	 *			user_ptr - user pointer associated with callback
+	 */
+	typedef	void (*FuncGetBinsCB)(int, int, int, T *, void *);
+
+	/*
+	 * FuncCompleteCB Type
+	 *
+	 * Callback function type for completion of executeAsync()
+	 *		void complete_cb(FFTAudioBaseT &ffta, int64_t ticket, void *user_ptr)
+	 *			ffta - object that executed the batch
+	 *			ticket - ticket returned by executeAsync()
+	 *			user_ptr - user pointer associated with callback
+	 */
+	typedef	void (*FuncCompleteCB)(FFTAudioBaseT &, int64_t, void *);
 
 protected:
 	/*
-	 * FFTAudioBase class constructor
+	 * FFTAudioBaseT class constructor
 	 *		window_type - fft window type/function, from fftaudio_windows.h
 	 *		sample_rate - sample rate, in hz
 	 *		frame_size - frame size, in samples
@@ -59,14 +299,14 @@ protected:
 	 *			Can be 0, in which case padded frame size == frame_size
 	 *		batch_count - Number of fft's to perform
 	 */
-	FFTAudioBase(FuncInitWindowCB window_type, int sample_rate,
-				 int frame_size, int padded_frame_size, int batch_count);
+	FFTAudioBaseT(FuncInitWindowCB window_type, int sample_rate,
+				  int frame_size, int padded_frame_size, int batch_count);
 
 public:
 	/*
-	 * FFTAudioBase class destructor
+	 * FFTAudioBaseT class destructor
 	 */
-	virtual ~FFTAudioBase();
+	virtual ~FFTAudioBaseT();
 
 protected:
 	/*
@@ -85,21 +325,173 @@ public:
 	 *
 	 * Executes a batch of fft's
 	 *
-	 * data - Pointer to sample data (signed 16-bit), number of samples must equal
-	 *			'frame_size' * 'batch_count'.
-	 * data_ptrs - 'batch_count' array of pointers to sample data (signed 16-bit),
-	 *			each pointer must point to an array of 'frame_size' samples.
+	 * data - Pointer to sample data, number of samples must equal
+	 *			'frame_size' * 'batch_count' (times 'channel_stride').
+	 * data_ptrs - 'batch_count' array of pointers to sample data, each pointer
+	 *			must point to an array of 'frame_size' samples (times
+	 *			'channel_stride').
+	 * channel_stride - distance between consecutive samples of a frame, in
+	 *			samples.  For interleaved multichannel data this is the channel
+	 *			count, with the data pointer(s) offset to the channel to use.
+	 *			Must be at least 1.
+	 *
+	 * Sample types are converted to the range -1.0 --> 1.0 as follows:
+	 *		short - signed 16-bit, divided by 2^15
+	 *		fftaInt24 - packed signed 24-bit little-endian, divided by 2^23
+	 *		int32_t - signed 32-bit, divided by 2^31
+	 *		float, double - used as is
+	 *
+	 *	  Returns false if not initialized or 'channel_stride' is less than 1
+	 */
+	bool execute(const short *data, int channel_stride = 1);
+	bool execute(const short * const *data_ptrs, int channel_stride = 1);
+	bool execute(const fftaInt24 *data, int channel_stride = 1);
+	bool execute(const fftaInt24 * const *data_ptrs, int channel_stride = 1);
+	bool execute(const int32_t *data, int channel_stride = 1);
+	bool execute(const int32_t * const *data_ptrs, int channel_stride = 1);
+	bool execute(const float *data, int channel_stride = 1);
+	bool execute(const float * const *data_ptrs, int channel_stride = 1);
+	bool execute(const double *data, int channel_stride = 1);
+	bool execute(const double * const *data_ptrs, int channel_stride = 1);
+
+	/*
+	 * executeAsync()
+	 *
+	 * Queues a batch of fft's and returns without waiting for the result.
+	 * Arguments are the same as execute().  The sample data must stay valid
+	 * until the batch completes, see wait() and setCompletionCallback().
+	 *
+	 * Batches complete in submission order, each one in its own buffer set
+	 * (see FFTAudio::setAsyncBufferCount()).  If every buffer set is in use
+	 * the call blocks until the oldest batch completes.  Results of a batch
+	 * stay readable until as many further batches as there are buffer sets
+	 * have been submitted.
+	 *
+	 * execute() and executeAsync() must be called from one thread at a time,
+	 * execute() waits for all queued batches first.
+	 *
+	 *	  Returns a ticket identifying the batch, or -1 on failure
+	 */
+	int64_t executeAsync(const short *data, int channel_stride = 1);
+	int64_t executeAsync(const short * const *data_ptrs, int channel_stride = 1);
+	int64_t executeAsync(const fftaInt24 *data, int channel_stride = 1);
+	int64_t executeAsync(const fftaInt24 * const *data_ptrs, int channel_stride = 1);
+	int64_t executeAsync(const int32_t *data, int channel_stride = 1);
+	int64_t executeAsync(const int32_t * const *data_ptrs, int channel_stride = 1);
+	int64_t executeAsync(const float *data, int channel_stride = 1);
+	int64_t executeAsync(const float * const *data_ptrs, int channel_stride = 1);
+	int64_t executeAsync(const double *data, int channel_stride = 1);
+	int64_t executeAsync(const double * const *data_ptrs, int channel_stride = 1);
+
+	/*
+	 * wait()
+	 *
+	 * Blocks until the batch identified by 'ticket' (and every batch queued
+	 * before it) has completed
+	 *
+	 *	  Returns false if 'ticket' was never issued
 	 */
-	virtual bool execute(const short *data) = 0;
-	virtual bool execute(const short * const *data_ptrs) = 0;
+	virtual bool wait(int64_t ticket);
+
+	/*
+	 * selectResult()
+	 *
+	 * Selects the completed batch whose results getBinValue(), getBinValues()
+	 * and getAllBinValues() return.  execute() selects its own results.
+	 * Results must be selected and read by one thread, either the one calling
+	 * wait() or the completion callback.
+	 *
+	 *	  Returns false if 'ticket' has not completed or its buffer set has
+	 *			been reused
+	 */
+	virtual bool selectResult(int64_t ticket);
+
+	/*
+	 * setCompletionCallback()
+	 *
+	 * Sets optional user callback called when a batch queued by executeAsync()
+	 * completes.  The callback runs on an internal thread, in submission order.
+	 *
+	 * cb_func - 'FuncCompleteCB' callback function
+	 * user_ptr - optinial user-specified pointer passed to callback function
+	 */
+	void setCompletionCallback(FuncCompleteCB cb_func, void *user_ptr = nullptr)
+	{
+		m_completeCallback = cb_func;
+		m_completeCallbackUserPointer = user_ptr;
+	}
 
 	/*
 	 * getBinValue()
 	 *
 	 * Retrieves a bin result value after execute() is called
 	 */
-	float getBinValue(int bin) const;
-	float getBinValue(int batch_idx, int bin) const;
+	T getBinValue(int bin) const;
+	T getBinValue(int batch_idx, int bin) const;
+
+	/*
+	 * getBinValues()
+	 *
+	 * Retrieves a block of bin result values for one batch after execute() is
+	 * called.  Performs the same post-processing as getBinValue() using
+	 * vectorized kernels.
+	 *
+	 * batch_idx - index of batch to read
+	 * out - array of at least 'count' values to receive the results
+	 * first_bin - index of first bin to read
+	 * count - number of bins to read, 'first_bin' + 'count' must not exceed
+	 *			getBinCount() + 1
+	 *
+	 *	  Returns false if not initialized or the bin range is invalid
+	 */
+	bool getBinValues(int batch_idx, T *out, int first_bin, int count) const;
+
+	/*
+	 * getAllBinValues()
+	 *
+	 * Retrieves the same block of bin result values for every batch.  Results
+	 * for batch 'n' are stored at &out[n * count].
+	 *
+	 * out - array of at least 'batch_count' * 'count' values
+	 * first_bin - index of first bin to read
+	 * count - number of bins to read per batch
+	 *
+	 *	  Returns false if not initialized or the bin range is invalid
+	 */
+	bool getAllBinValues(T *out, int first_bin, int count) const;
+
+	/*
+	 * getComplexSpectrum()
+	 *
+	 * Returns a read-only view of the raw complex fft output of one batch,
+	 * 'getBinCount() + 1' values without the scaling and callbacks of
+	 * getBinValue() (its magnitudes times getMagnitudeScale()).  The view
+	 * points into the results, so it is valid until they are overwritten by a
+	 * later batch using the same buffers.  Batches are getOutputStride()
+	 * complex values apart in the same buffer.
+	 *
+	 * batch_idx - index of batch to read
+	 *
+	 *	  Returns an empty view if not initialized or 'batch_idx' is invalid
+	 */
+	fftaComplexViewT<T> getComplexSpectrum(int batch_idx) const;
+
+	/*
+	 * getOutputStride()
+	 *
+	 * Returns the distance between the complex spectra of consecutive batches,
+	 * in complex values, getBinCount() + 1 unless slices are padded.  Valid
+	 * after initialize().
+	 */
+	int getOutputStride() const						{ return m_outputStride;				}
+
+	/*
+	 * getMagnitudeScale()
+	 *
+	 * Returns the factor getBinValue() applies to the magnitude of each raw
+	 * complex value, 2 / sum of the window values.  Valid after initialize().
+	 */
+	T getMagnitudeScale() const						{ return (T)2.0 / m_windowSum;			}
 
 	/*
 	 * setGetBinValueUserCallback()
@@ -124,29 +516,572 @@ public:
 		m_getBinCallbackUserPointer = user_ptr;
 	}
 
+	/*
+	 * setGetBinValuesUserCallback()
+	 *
+	 * Sets optional user callback for when getBinValues() or getAllBinValues()
+	 * is called.  The callback is called once per spectrum with the block of
+	 * automatically post-processed values.  If no block callback is set, the
+	 * per-bin callback from setGetBinValueUserCallback() is called for each bin
+	 * instead.
+	 *
+	 * cb_func - 'FuncGetBinsCB' callback function
+	 * user_ptr - optinial user-specified pointer passed to callback function
+	 */
+	void setGetBinValuesUserCallback(FuncGetBinsCB cb_func, void *user_ptr = nullptr)
+	{
+		m_getBinsCallback = cb_func;
+		m_getBinsCallbackUserPointer = user_ptr;
+	}
+
 	int getSampleRate() const						{ return m_sampleRate;					}
 	int getFrameSize() const						{ return m_frameSize;					}
 	int getPaddedFrameSize() const					{ return m_paddedFrameSize;				}
 	int getBatchCount() const						{ return m_batchCount;					}
 	int getBinCount() const							{ return m_binCount;					}
-	float getBinFrequency(int bin) const			{ return (float)bin * m_frequencyStep;	}
+	T getBinFrequency(int bin) const
+	{
+		return m_binFrequencies.empty() ? (T)bin * m_frequencyStep : m_binFrequencies[bin];
+	}
+
+	/*
+	 * setTargetFrequencies()
+	 *
+	 * Restricts the results to a list of target frequencies.  Must be called
+	 * before initialize().  Each frequency is rounded to the nearest bin of
+	 * 'padded_frame_size', result bin 'n' then holds target 'n', so
+	 * getBinCount() returns 'count' - 1 and getBinFrequency() the rounded
+	 * frequency of each target.
+	 *
+	 * Small target sets are evaluated with the Goertzel algorithm over the
+	 * windowed input instead of a full fft, larger ones (see
+	 * GOERTZEL_BREAK_EVEN) compute the fft and keep the target bins.  The
+	 * Goertzel recurrence runs in double precision, so both agree to within
+	 * the float rounding of the input and results.  Not compatible with
+	 * setMelFilterbank(), setPeakDetection() or setZoom().
+	 *
+	 * frequencies - array of 'count' frequencies, in hz, 0 --> sample_rate / 2
+	 * count - number of target frequencies
+	 *
+	 *	  Returns false if already initialized or an argument is invalid
+	 */
+	bool setTargetFrequencies(const T *frequencies, int count);
+
+	/*
+	 * setZoom()
+	 *
+	 * Restricts the results to a band of 'bin_count' evenly spaced
+	 * frequencies, 'start_frequency' --> 'stop_frequency' inclusive.  Must be
+	 * called before initialize().  The band is computed with a chirp-z
+	 * (Bluestein) transform of the windowed frame, so the frequency resolution
+	 * is independent of 'padded_frame_size', which is ignored.  getBinCount()
+	 * returns 'bin_count' - 1 and getBinFrequency() the frequency of each bin.
+	 *
+	 * Not supported by the cuda api (initialize() returns FFTA_UNSUPPORTED),
+	 * not compatible with setTargetFrequencies().
+	 *
+	 * start_frequency, stop_frequency - band edges, in hz, 0 --> sample_rate / 2
+	 * bin_count - number of bins, at least 2
+	 *
+	 *	  Returns false if already initialized or an argument is invalid
+	 */
+	bool setZoom(T start_frequency, T stop_frequency, int bin_count);
+
+	/*
+	 * usesGoertzel()
+	 *
+	 * Returns true if target frequencies are evaluated with the Goertzel
+	 * algorithm, valid after initialize()
+	 */
+	bool usesGoertzel() const						{ return m_goertzel;					}
+
+	/*
+	 * The Goertzel algorithm is used while 'count' * 'frame_size' is at most
+	 * this factor times 'padded_frame_size' * log2('padded_frame_size')
+	 */
+	static constexpr double GOERTZEL_BREAK_EVEN = 1.0;
+
+	/*
+	 * setMelFilterbank()
+	 *
+	 * Enables the mel output stage.  Must be called before initialize().  After
+	 * each fft the power spectrum of every batch is reduced to mel band
+	 * energies with triangular (HTK) filters, on the threads that computed the
+	 * batch, without going through getBinValue().
+	 *
+	 * band_count - number of mel bands
+	 * min_frequency - lower edge of the first band, in hz
+	 * max_frequency - upper edge of the last band, in hz, 0 selects the
+	 *			nyquist frequency
+	 * mfcc_count - number of cepstral coefficients (DCT-II of the log band
+	 *			energies) to compute, 0 disables, must not exceed 'band_count'
+	 * log_energies - store natural log band energies instead of linear ones,
+	 *			required for 'mfcc_count' > 0
+	 *
+	 *	  Returns false if already initialized or an argument is invalid
+	 */
+	bool setMelFilterbank(int band_count, T min_frequency = 0, T max_frequency = 0,
+						  int mfcc_count = 0, bool log_energies = true);
+
+	/*
+	 * getMelBands() / getMfcc()
+	 *
+	 * Retrieves the mel band energies ('band_count' values) or cepstral
+	 * coefficients ('mfcc_count' values) of one batch after execute() is called
+	 *
+	 *	  Returns false if not initialized or the stage isn't enabled
+	 */
+	bool getMelBands(int batch_idx, T *out) const;
+	bool getMfcc(int batch_idx, T *out) const;
+
+	/*
+	 * addSpectrumStage()
+	 *
+	 * Appends a stage to the spectrum pipeline.  Must be called before
+	 * initialize().  When at least one stage is added, the processed spectrum
+	 * of every batch is computed after each fft with vectorized kernels, on the
+	 * threads that computed the batch, and read with getSpectrum().
+	 *
+	 * stage - 'fftaSpectrumStage' value
+	 * param1, param2 - stage parameters, see fftaSpectrumStage
+	 *
+	 *	  Returns false if already initialized or the stage or its parameters
+	 *			are invalid at this point of the pipeline
+	 */
+	bool addSpectrumStage(fftaSpectrumStage stage, T param1 = 0, T param2 = 0);
+
+	/*
+	 * getSpectrum()
+	 *
+	 * Retrieves a block of processed spectrum values for one batch after
+	 * execute() is called, same arguments as getBinValues()
+	 *
+	 *	  Returns false if not initialized, no stage was added or the bin range
+	 *			is invalid
+	 */
+	bool getSpectrum(int batch_idx, T *out, int first_bin, int count) const;
+
+	int getSpectrumStageCount() const				{ return (int)m_spectrumStages.size();	}
+
+	/*
+	 * setAveraging()
+	 *
+	 * Enables spectrum averaging.  Must be called before initialize().  Each
+	 * thread that computes batches accumulates their power into its own
+	 * buffer, the buffers are then reduced in parallel into one averaged
+	 * spectrum, read with getAverage().
+	 *
+	 * mode - 'fftaAverageMode' value
+	 * alpha - FFTA_AVERAGE_EXPONENTIAL only, weight of each new spectrum,
+	 *			0 < 'alpha' <= 1
+	 *
+	 *	  Returns false if already initialized or 'alpha' is out of range
+	 */
+	bool setAveraging(fftaAverageMode mode, T alpha = (T)0.1);
+
+	/*
+	 * getAverage()
+	 *
+	 * Retrieves a block of the averaged spectrum after execute() is called,
+	 * same bin range arguments as getBinValues().  With executeAsync() the
+	 * average includes every completed batch, read it from the completion
+	 * callback or once no batch is queued.
+	 *
+	 *	  Returns false if not initialized, averaging isn't enabled or the bin
+	 *			range is invalid
+	 */
+	bool getAverage(T *out, int first_bin, int count) const;
+
+	/*
+	 * resetAverage()
+	 *
+	 * Restarts the exponential and peak-hold averages, must not be called while
+	 * a batch is executing
+	 */
+	void resetAverage();
+
+	/*
+	 * setPeakDetection()
+	 *
+	 * Enables peak detection.  Must be called before initialize().  After each
+	 * fft the strongest local maxima of every batch are found on the threads
+	 * that computed the batch, and their frequency and amplitude refined by
+	 * parabolic interpolation of the log amplitude of the neighbouring bins.
+	 *
+	 * max_peaks - number of peaks kept per batch, by interpolated amplitude
+	 * min_level - peaks whose interpolated amplitude is below this are ignored
+	 *
+	 *	  Returns false if already initialized or 'max_peaks' is less than 1
+	 */
+	bool setPeakDetection(int max_peaks, T min_level = 0);
+
+	/*
+	 * getPeaks()
+	 *
+	 * Retrieves the strongest peaks of one batch after execute() is called,
+	 * strongest first
+	 *
+	 * batch_idx - index of batch to read
+	 * count - maximum number of peaks to return, at most 'max_peaks'
+	 * min_level - only return peaks with at least this amplitude
+	 * out - array of at least 'count' peaks
+	 *
+	 *	  Returns the number of peaks stored in 'out', or -1 if not initialized
+	 *			or peak detection isn't enabled
+	 */
+	int getPeaks(int batch_idx, int count, T min_level, fftaPeakT<T> *out) const;
+
+	int getMaxPeaks() const							{ return m_peakMaxCount;				}
+
+	fftaAverageMode getAverageMode() const			{ return m_averageMode;					}
+
+	/*
+	 * setStatsEnabled()
+	 *
+	 * Enables execution statistics.  Must be called before initialize().  Each
+	 * thread times its own stages into its own counters with clock_gettime(),
+	 * getStats() sums them, so the cost is a few clock reads per batch.
+	 *
+	 *	  Returns false if already initialized
+	 */
+	bool setStatsEnabled(bool enable);
+
+	/*
+	 * getStats()
+	 *
+	 * Retrieves the statistics, may be called from any thread at any time.
+	 * Counters of a batch that is executing may be partially updated.
+	 *
+	 *	  Returns false if not initialized or statistics aren't enabled
+	 */
+	bool getStats(fftaStats &stats) const;
+
+	/*
+	 * resetStats()
+	 *
+	 * Clears the statistics, must not be called while a batch is executing
+	 */
+	void resetStats();
+
+	int getMelBandCount() const						{ return m_melBandCount;				}
+	int getMfccCount() const						{ return m_mfccCount;					}
+
+	/*
+	 * Band energies below this value are clamped before taking the log
+	 */
+	static constexpr double MEL_LOG_FLOOR = 1e-10;
 
 protected:
-	virtual float _prepare_input_value(int frame_index, short sample_value)
+	/*
+	 * Sample formats accepted by execute()
+	 */
+	typedef enum ffta_sample_format_enum {
+		FFTA_SAMPLE_S16 = 0,
+		FFTA_SAMPLE_S24,
+		FFTA_SAMPLE_S32,
+		FFTA_SAMPLE_F32,
+		FFTA_SAMPLE_F64
+	} fftaSampleFormat;
+
+	/*
+	 * Description of the sample data passed to execute(), either one contiguous
+	 * array or an array of per-batch pointers
+	 */
+	class inputDescriptor
 	{
-		float ret = (float)sample_value;
+	public:
+		inputDescriptor(fftaSampleFormat format, size_t sample_size, const void *data,
+						const void * const *data_ptrs, int channel_stride)
+		{
+			idm_format = format;
+			idm_sampleSize = sample_size;
+			idm_data = data;
+			idm_dataPointers = data_ptrs;
+			idm_channelStride = channel_stride;
+		}
 
-		ret /= (float)MAXSHORT + 1.0f;
-		ret *= m_windowValues[frame_index];
-		return ret;
+		virtual ~inputDescriptor() = default;
+
+		/*
+		 * Returns false if the arguments can't describe any sample data
+		 */
+		bool isValid() const
+		{
+			return (idm_channelStride > 0);
+		}
+
+		/*
+		 * Returns pointer to the first sample of frame 'batch_index'
+		 */
+		const void *getFrame(int batch_index, int frame_size) const
+		{
+			if(idm_dataPointers != nullptr) {
+				return idm_dataPointers[batch_index];
+			}
+
+			return (const char *)idm_data + ((size_t)batch_index * frame_size * idm_channelStride * idm_sampleSize);
+		}
+
+	public:
+		fftaSampleFormat		idm_format;
+		size_t					idm_sampleSize;
+		const void				*idm_data;
+		const void * const		*idm_dataPointers;
+		int						idm_channelStride;
+	};
+
+	/*
+	 * Executes a batch of fft's on the described input, implemented by the api
+	 * specific class
+	 */
+	virtual bool _execute(const inputDescriptor &input) = 0;
+
+	/*
+	 * Queues a batch of fft's on the described input.  The default runs the
+	 * batch synchronously through _execute() and calls the completion callback.
+	 */
+	virtual int64_t _execute_async(const inputDescriptor &input);
+
+	/*
+	 * Calls the completion callback, if set, for 'ticket'
+	 */
+	void _notify_complete(int64_t ticket)
+	{
+		if(m_completeCallback != nullptr) {
+			(*m_completeCallback)(*this, ticket, m_completeCallbackUserPointer);
+		}
 	}
 
-	virtual float _get_complex_result(int idx) const = 0;
+	/*
+	 * Converts and windows the 'frame_size' samples of batch 'batch_index' into
+	 * 'output'.  Uses vectorized kernels, unless a derived class overrides
+	 * _prepare_input_value(), in which case 16-bit samples are converted one at
+	 * a time through the override.
+	 */
+	void _prepare_input_frame(const inputDescriptor &input, int batch_index, T *output);
+
+	/*
+	 * Converts and windows a single 16-bit sample.  Derived classes may override
+	 * this to customize conversion, at the cost of the vectorized input path.
+	 */
+	virtual T _prepare_input_value(int frame_index, short sample_value);
+
+	virtual T _get_complex_result(int idx) const = 0;
+
+	/*
+	 * Returns the output buffer as interleaved (real, imaginary) 'T' pairs,
+	 * 'getBinCount() + 1' complex values per batch, _get_output_stride()
+	 * complex values apart.
+	 */
+	virtual const T *_get_complex_buffer() const = 0;
+
+	/*
+	 * Per-batch slice padding.  With a slice alignment set (a power of two
+	 * bytes, before initialize()), each batch's slice of a buffer starts on a
+	 * multiple of it, so threads writing neighbouring batches don't share cache
+	 * lines (or pages).  0 packs the slices.
+	 *
+	 * _align_slice() rounds 'count' values of 'value_size' bytes up to the slice
+	 * alignment.  _get_output_stride() is the distance between batches of the
+	 * output buffer in complex values, _get_post_process_stride() the one of the
+	 * output stage buffer in 'T' values.  Valid after initialize().
+	 */
+	void _set_slice_alignment(int bytes);
+	int _get_slice_alignment() const				{ return m_sliceAlignment;				}
+	int _align_slice(int count, size_t value_size) const;
+	int _get_output_stride() const					{ return m_outputStride;				}
+	int _get_post_process_stride() const			{ return m_postProcessStride;			}
+
+	/*
+	 * Number of 'T' values each batch's output stages produce, 0 if no output
+	 * stage is enabled.  Valid after initialize().
+	 */
+	int _get_post_process_size() const				{ return m_postProcessSize;				}
+
+	/*
+	 * Runs the enabled output stages for one batch
+	 *		complex_in - the batch's 'getBinCount() + 1' interleaved complex values
+	 *		out - the batch's _get_post_process_size() output values
+	 */
+	void _post_process_batch(const T *complex_in, T *out) const;
+
+	/*
+	 * Returns the output stage buffer matching _get_complex_buffer(),
+	 * _get_post_process_size() values per batch, _get_post_process_stride()
+	 * values apart
+	 */
+	virtual const T *_get_post_process_buffer() const = 0;
+
+	/*
+	 * Number of bins of the fft, 'padded_frame_size' / 2.  Same as
+	 * getBinCount() unless target frequencies are set, the fft then produces
+	 * _get_transform_bin_count() + 1 complex values per batch, reduced to
+	 * getBinCount() + 1 with _gather_targets().
+	 */
+	int _get_transform_bin_count() const			{ return m_transformBinCount;			}
+
+	bool _has_target_frequencies() const			{ return !m_targetBins.empty();			}
+
+	/*
+	 * Chirp-z transform of setZoom(), for each batch the api specific class:
+	 *		1. _zoom_premultiply() the windowed frame into a work buffer of
+	 *		   _get_zoom_length() complex values
+	 *		2. transforms the work buffer forward
+	 *		3. _zoom_convolve() it with the filter, which _init_zoom_filter()
+	 *		   fills in the time domain and is transformed forward once
+	 *		4. transforms the work buffer backward
+	 *		5. _zoom_postmultiply() the work buffer into the output
+	 */
+	bool _uses_zoom() const							{ return m_zoomBinCount > 0;			}
+	int _get_zoom_length() const					{ return m_zoomLength;					}
+	void _init_zoom_filter(T *filter) const;
+	void _zoom_premultiply(const T *frame, T *work) const;
+	void _zoom_convolve(T *work, const T *filter) const;
+	void _zoom_postmultiply(const T *work, T *complex_out) const;
+
+	/*
+	 * Evaluates the target frequencies of one windowed frame
+	 *		frame - the batch's 'frame_size' windowed samples
+	 *		complex_out - the batch's 'getBinCount() + 1' interleaved complex values
+	 */
+	void _goertzel_batch(const T *frame, T *complex_out) const;
+
+	/*
+	 * Copies the target bins of one batch's fft
+	 *		spectrum - the batch's _get_transform_bin_count() + 1 complex values
+	 *		complex_out - the batch's 'getBinCount() + 1' complex values
+	 */
+	void _gather_targets(const T *spectrum, T *complex_out) const;
+
+	/*
+	 * Returns true if setAveraging() enabled averaging
+	 */
+	bool _is_averaging() const						{ return m_averageMode != FFTA_AVERAGE_NONE;	}
+
+	/*
+	 * Distance between per-thread average accumulators, in 'T' values.
+	 * 'getBinCount() + 1' rounded up to a whole number of cache lines (or of
+	 * the slice alignment, if larger), so threads never write to the same
+	 * line.
+	 */
+	int _get_average_stride() const;
+
+	/*
+	 * Adds the power of batch 'batch_index' to a thread's accumulator
+	 *		complex_in - the batch's 'getBinCount() + 1' interleaved complex values
+	 *		accumulator - _get_average_stride() values owned by the calling thread
+	 */
+	void _accumulate_average(const T *complex_in, int batch_index, T *accumulator) const;
+
+	/*
+	 * Merges bins 'first_bin' --> 'first_bin' + 'count' - 1 of the
+	 * 'accumulator_count' accumulators into the average and clears them.
+	 * Disjoint bin ranges may be reduced concurrently.
+	 */
+	void _reduce_average(T *accumulators, int accumulator_count, int first_bin, int count);
+
+	/*
+	 * Called once per batch after every bin range has been reduced
+	 */
+	void _finish_average();
+
+	/*
+	 * Cache line size accumulators and reduce ranges are aligned to
+	 */
+	static const int AVERAGE_ALIGNMENT = 64;
+
+	/*
+	 * Execution statistics, each thread adds to its own counters.  Slots
+	 * 0 --> 'thread_count' - 1 of _init_stats() belong to the worker threads,
+	 * slot 'thread_count' to the thread running the batch (execute() or a
+	 * coordinator), which also records the batch latency.
+	 */
+	fftaStatus _init_stats(int thread_count);
+
+	bool _stats_enabled() const						{ return m_statsCounters != nullptr;	}
+
+	static uint64_t _stats_clock()
+	{
+		struct timespec		ts;
+
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+	}
+
+	void _stats_add_stage(int slot, fftaStatsStage stage, uint64_t ns)
+	{
+		statsCounters	&c = m_statsCounters[slot];
+
+		_stats_add(c.scm_stageNs[stage], ns);
+		_stats_add(c.scm_stageCalls[stage], 1);
+	}
+
+	void _stats_add_worker(int slot, uint64_t busy_ns, uint64_t idle_ns, uint64_t items)
+	{
+		statsCounters	&c = m_statsCounters[slot];
+
+		_stats_add(c.scm_busyNs, busy_ns);
+		_stats_add(c.scm_idleNs, idle_ns);
+		_stats_add(c.scm_items, items);
+	}
+
+	void _stats_add_batch(uint64_t latency_ns);
+
+private:
+	bool		_has_default_input_conversion();
+	void		_init_mel_filterbank();
+	void		_init_target_bins();
+	void		_init_zoom();
+	void		_init_spectrum_stages();
+	void		_process_spectrum(const T *complex_in, T *spectrum, T *scratch) const;
+	void		_find_peaks(const T *complex_in, T *peaks, T *amplitudes) const;
+	const T		*_get_batch_post_process(int batch_index) const;
+
+private:
+	/*
+	 * Window tables are immutable once computed, so instances with the same
+	 * window function and frame size share one reference counted entry
+	 */
+	class windowEntry
+	{
+	public:
+		FuncInitWindowCB		wdm_windowCallback;
+		int						wdm_frameSize;
+		int						wdm_refCount;
+		T						wdm_windowSum;
+		T						*wdm_values;
+	};
+
+	static windowEntry	*_acquire_window(FuncInitWindowCB window_cb, int frame_size);
+	static void			_release_window(windowEntry *entry);
+
+	/*
+	 * Per-thread statistics counters, one cache line aligned slot per thread.
+	 * Only the owning thread writes a slot, so updates are a relaxed load and
+	 * store rather than an atomic add.
+	 */
+	class statsCounters
+	{
+	public:
+		alignas(AVERAGE_ALIGNMENT) std::atomic<uint64_t>	scm_stageNs[FFTA_STATS_STAGE_COUNT];
+		std::atomic<uint64_t>	scm_stageCalls[FFTA_STATS_STAGE_COUNT];
+		std::atomic<uint64_t>	scm_busyNs;
+		std::atomic<uint64_t>	scm_idleNs;
+		std::atomic<uint64_t>	scm_items;
+	};
+
+	static void _stats_add(std::atomic<uint64_t> &counter, uint64_t value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	static std::vector<windowEntry *>	sm_windowCache;
+	static pthread_mutex_t				sm_windowMutex;
 
 protected:
 	bool					m_initialized = false;
 	bool					m_initializeFailed = false;
-	float					*m_inputBuffer = nullptr;
+	T						*m_inputBuffer = nullptr;
 
 private:
 	int						m_sampleRate = 0;
@@ -154,13 +1089,148 @@ private:
 	int						m_paddedFrameSize = 0;
 	int						m_batchCount = 0;
 	int						m_binCount = 0;
-	float					m_frequencyStep = 0.0f;
-	float					*m_windowValues = nullptr;
-	float					m_windowSum = 0.0f;
+	int						m_transformBinCount = 0;
+	int						m_sliceAlignment = 0;
+	int						m_outputStride = 0;
+	T						m_binSpacing = 0;
+
+	/*
+	 * Frequency of each result bin when it isn't 'bin' * 'm_frequencyStep'
+	 */
+	std::vector<T>			m_binFrequencies;
+	T						m_frequencyStep = 0;
+	windowEntry				*m_window = nullptr;
+	const T					*m_windowValues = nullptr;
+	const T					*m_scaledWindowValues = nullptr;
+	T						m_windowSum = 0;
+	bool					m_vectorizedInput = false;
 	FuncInitWindowCB		m_windowInitCallback = nullptr;
 	FuncGetBinCB			m_getBinCallback = nullptr;
 	void					*m_getBinCallbackUserPointer = nullptr;
+	FuncGetBinsCB			m_getBinsCallback = nullptr;
+	void					*m_getBinsCallbackUserPointer = nullptr;
+	FuncCompleteCB			m_completeCallback = nullptr;
+	void					*m_completeCallbackUserPointer = nullptr;
+	int64_t					m_syncTickets = 0;
+
+	/*
+	 * Target frequencies, 'm_targetBins' holds the fft bin of each one.
+	 * 'm_goertzelCoeffs' holds the cos(w) of every target followed by their
+	 * sin(w), in double for the recurrence, 'm_goertzelTwiddles' the cos/sin
+	 * of the phase of the last frame sample, w * ('frame_size' - 1).
+	 */
+	std::vector<T>			m_targetFrequencies;
+	std::vector<int>		m_targetBins;
+	bool					m_goertzel = false;
+	std::vector<double>		m_goertzelCoeffs;
+	std::vector<T>			m_goertzelTwiddles;
+
+	/*
+	 * Zoom band.  The chirp-z transform of length 'm_zoomLength' uses
+	 * 'frame_size' pre-multiplication and 'bin_count' post-multiplication
+	 * chirps, as interleaved complex values.
+	 */
+	T						m_zoomStart = 0;
+	T						m_zoomStop = 0;
+	int						m_zoomBinCount = 0;
+	int						m_zoomLength = 0;
+	std::vector<T>			m_zoomPreChirp;
+	std::vector<T>			m_zoomPostChirp;
+
+	/*
+	 * Spectrum pipeline stage.  'ssm_domain' is the domain of the values the
+	 * stage receives, 'ssm_table' holds per-bin weighting gains in that domain.
+	 */
+	class spectrumStage
+	{
+	public:
+		enum {
+			DOMAIN_AMPLITUDE = 0,
+			DOMAIN_POWER,
+			DOMAIN_DB
+		};
+
+	public:
+		fftaSpectrumStage		ssm_stage;
+		T						ssm_param1;
+		T						ssm_param2;
+		int						ssm_domain;
+		std::vector<T>			ssm_table;
+	};
+
+	/*
+	 * Output stages, each batch's output is laid out as the processed spectrum
+	 * at 'm_spectrumOffset' (plus smoothing scratch space), mel bands at
+	 * 'm_melOffset' and cepstral coefficients at 'm_mfccOffset'
+	 */
+	int						m_postProcessSize = 0;
+	int						m_postProcessStride = 0;
+	std::vector<spectrumStage>	m_spectrumStages;
+	int						m_spectrumDomain = spectrumStage::DOMAIN_AMPLITUDE;
+	int						m_spectrumOffset = 0;
+	int						m_spectrumScratchOffset = -1;
+	int						m_melBandCount = 0;
+	T						m_melMinFrequency = 0;
+	T						m_melMaxFrequency = 0;
+	bool					m_melLog = false;
+	int						m_melOffset = 0;
+	int						m_mfccCount = 0;
+	int						m_mfccOffset = 0;
+
+	/*
+	 * Peak detection output, the peak count followed by 'm_peakMaxCount'
+	 * (frequency, amplitude, bin) triplets at 'm_peakOffset', plus the bin
+	 * amplitudes at 'm_peakScratchOffset'
+	 */
+	int						m_peakMaxCount = 0;
+	T						m_peakMinLevel = 0;
+	int						m_peakOffset = 0;
+	int						m_peakScratchOffset = 0;
+
+	/*
+	 * Sparse mel filter matrix, band 'b' covers 'm_melBinCount[b]' bins from
+	 * 'm_melFirstBin[b]' with weights from &m_melWeights[m_melWeightIndex[b]].
+	 * 'm_dctMatrix' holds 'mfcc_count' rows of 'band_count' DCT-II factors.
+	 */
+	std::vector<int>		m_melFirstBin;
+	std::vector<int>		m_melBinCount;
+	std::vector<int>		m_melWeightIndex;
+	std::vector<T>			m_melWeights;
+	std::vector<T>			m_dctMatrix;
+
+	/*
+	 * Spectrum averaging.  'm_averageWeights' holds the per-batch weight of
+	 * each power spectrum (scale included), 'm_averageState' the running
+	 * average, scaled by 'm_averageCorrection' on readout to remove the bias of
+	 * the zero-initialized exponential average.
+	 */
+	fftaAverageMode			m_averageMode = FFTA_AVERAGE_NONE;
+	T						m_averageAlpha = (T)0.1;
+	T						m_averageDecay = 0;
+	T						m_averageCorrection = 1;
+	int64_t					m_averageFrames = 0;
+	std::vector<T>			m_averageWeights;
+	std::vector<T>			m_averageState;
+
+	/*
+	 * Execution statistics, 'm_statsThreadCount' + 1 counter slots and the
+	 * batch latency written by the thread running the batch
+	 */
+	bool					m_statsEnabled = false;
+	int						m_statsThreadCount = 0;
+	statsCounters			*m_statsCounters = nullptr;
+	std::atomic<uint64_t>	m_statsBatches;
+	std::atomic<uint64_t>	m_statsLatencyTotal;
+	std::atomic<uint64_t>	m_statsLatencyMax;
+	std::atomic<uint64_t>	m_statsLatencyHistogram[fftaStats::LATENCY_BUCKETS];
 };
 
+
+extern template class FFTAudioBaseT<float>;
+extern template class FFTAudioBaseT<double>;
+
+typedef FFTAudioBaseT<float>	FFTAudioBase;
+typedef FFTAudioBaseT<double>	FFTAudioBaseDouble;
+
 #endif // FFTA__BASE__H__
 
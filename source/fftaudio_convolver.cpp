@@ -0,0 +1,402 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include	<cstring>
+#include	<vector>
+
+#include	<fftaudio_status.h>
+#include	<fftaudio_windows.h>
+#include	<fftaudio_simd.h>
+#include	<fftaudio_convolver.h>
+
+
+static inline void
+_complex_multiply(const float *a, const float *b, float *out, int count)
+{
+	fftaSimd::complexMultiply(a, b, out, count);
+}
+
+static inline void
+_complex_multiply(const double *a, const double *b, double *out, int count)
+{
+	double	re;
+	double	im;
+
+	for(int i = 0; i < count; ++i) {
+		re = (a[2 * i] * b[2 * i]) - (a[(2 * i) + 1] * b[(2 * i) + 1]);
+		im = (a[2 * i] * b[(2 * i) + 1]) + (a[(2 * i) + 1] * b[2 * i]);
+		out[2 * i] = re;
+		out[(2 * i) + 1] = im;
+	}
+}
+
+static inline void
+_complex_multiply_accumulate(const float *a, const float *b, float *acc, int count)
+{
+	fftaSimd::complexMultiplyAccumulate(a, b, acc, count);
+}
+
+static inline void
+_complex_multiply_accumulate(const double *a, const double *b, double *acc, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		acc[2 * i] += (a[2 * i] * b[2 * i]) - (a[(2 * i) + 1] * b[(2 * i) + 1]);
+		acc[(2 * i) + 1] += (a[2 * i] * b[(2 * i) + 1]) + (a[(2 * i) + 1] * b[2 * i]);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioConvolverT Constructor
+ ***************************************************************/
+
+/*
+ * The engine runs one rectangular-windowed frame of 2 * 'block_size' samples
+ * per channel, the sample rate isn't used
+ */
+template<typename T>
+FFTAudioConvolverT<T>::FFTAudioConvolverT(int block_size, int channel_count) :
+	FFTAudioT<T>(fftaWindow::Rectangle, 1, 2 * block_size, 0, channel_count)
+{
+	m_blockSize = block_size;
+	m_channelTaps.resize((channel_count > 0) ? channel_count : 0);
+
+	/*
+	 * Cache line aligned slices keep every buffer in the plans' simd alignment,
+	 * so the delay line and filter spectra can be transformed in place
+	 */
+	this->setSliceAlignment(FFTAudioBaseT<T>::AVERAGE_ALIGNMENT);
+	this->_enable_inverse_transform();
+}
+
+
+/***************************************************************
+ * FFTAudioConvolverT Destructor
+ ***************************************************************/
+
+template<typename T>
+FFTAudioConvolverT<T>::~FFTAudioConvolverT()
+{
+	// Note: the buffers are carved from the FFTAudioT arena
+}
+
+
+/***************************************************************
+ * FFTAudioConvolverT::initialize()
+ ***************************************************************/
+
+template<typename T>
+fftaStatus
+FFTAudioConvolverT<T>::initialize()
+{
+	const std::vector<T>	*taps;
+	fftaStatus				ret;
+	size_t					i;
+	int						partitions;
+
+	if(this->m_initializeFailed) {
+		return FFTA_PREVIOUS_INITIALIZE_FAILED;
+	}
+
+	if(this->m_initialized) {
+		return FFTA_ALREADY_INITIALIZED;
+	}
+
+	if(m_blockSize < 1 || m_channelTaps.empty()) {
+		this->m_initializeFailed = true;
+		return FFTA_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Map each channel to a distinct filter, the longest one sets the
+	 * partition count
+	 */
+	m_partitionCount = 0;
+
+	for(int c = 0; c < (int)m_channelTaps.size(); ++c) {
+		taps = !m_channelTaps[c].empty() ? &m_channelTaps[c] : &m_defaultTaps;
+
+		if(taps->empty()) {
+			this->m_initializeFailed = true;
+			return FFTA_INVALID_ARGUMENT;
+		}
+
+		for(i = 0; i < m_filters.size() && m_filters[i] != taps; ++i) {
+		}
+
+		if(i == m_filters.size()) {
+			m_filters.push_back(taps);
+		}
+
+		m_channelFilter.push_back((int)i);
+
+		partitions = ((int)taps->size() + m_blockSize - 1) / m_blockSize;
+		if(partitions > m_partitionCount) {
+			m_partitionCount = partitions;
+		}
+	}
+
+	/*
+	 * Creates the plans and threads, and allocates the buffers of
+	 * _reserve_buffers()
+	 */
+	if((ret = FFTAudioT<T>::initialize()) != FFTA_SUCCESS) {
+		return ret;
+	}
+
+	this->_init_filter_spectra();
+	return FFTA_SUCCESS;
+}
+
+
+/***************************************************************
+ * FFTAudioConvolverT::setFilter()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioConvolverT<T>::setFilter(int channel, const T *taps, int tap_count)
+{
+	if(this->m_initialized || this->m_initializeFailed) {
+		return false;
+	}
+
+	if(channel < -1 || channel >= (int)m_channelTaps.size() || taps == nullptr || tap_count < 1) {
+		return false;
+	}
+
+	if(channel == -1) {
+		m_defaultTaps.assign(taps, taps + tap_count);
+	}
+	else {
+		m_channelTaps[channel].assign(taps, taps + tap_count);
+	}
+
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioConvolverT::process()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioConvolverT<T>::process(const T *const *input, T *const *output)
+{
+	uint64_t	start = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	FFTA_ALLOC_CHECK_SCOPE();
+
+	if(!this->m_initialized) {
+		return false;
+	}
+
+	m_processInput = input;
+	m_processOutput = output;
+
+	this->_dispatch(static_cast<typename FFTAudioT<T>::FuncJob>(&FFTAudioConvolverT::_job_channel),
+					this->getBatchCount());
+
+	m_processInput = nullptr;
+	m_processOutput = nullptr;
+
+	/*
+	 * The next block's spectrum replaces the oldest one
+	 */
+	m_delaySlot = (m_delaySlot + 1) % m_partitionCount;
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_batch(this->_stats_clock() - start);
+	}
+
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioConvolverT::reset()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioConvolverT<T>::reset()
+{
+	if(!this->m_initialized) {
+		return;
+	}
+
+	::memset(this->m_inputBuffer, 0, (size_t)this->getBatchCount() * this->getInputStride() * sizeof(T));
+	::memset(m_delayLine, 0,
+			 (size_t)this->getBatchCount() * m_partitionCount * m_spectrumStride * 2 * sizeof(T));
+
+	m_delaySlot = 0;
+}
+
+
+/***************************************************************
+ ****************** Protected Member Functions *****************
+ ***************************************************************/
+
+/***************************************************************
+ * FFTAudioConvolverT::_reserve_buffers() / _assign_buffers()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioConvolverT<T>::_reserve_buffers(fftaArena &arena, size_t alignment, int worker_count)
+{
+	size_t		spectrum_sz;
+
+	m_spectrumStride = this->_align_slice(m_blockSize + 1, 2 * sizeof(T));
+	spectrum_sz = (size_t)m_spectrumStride * 2 * sizeof(T);
+
+	m_filterSpectraAt = arena.reserve(m_filters.size() * m_partitionCount * spectrum_sz, alignment);
+	m_delayLineAt = arena.reserve((size_t)this->getBatchCount() * m_partitionCount * spectrum_sz, alignment);
+	m_accumulatorsAt = arena.reserve((size_t)worker_count * spectrum_sz, alignment);
+	m_timeBuffersAt = arena.reserve((size_t)worker_count * this->getInputStride() * sizeof(T), alignment);
+}
+
+
+template<typename T>
+void
+FFTAudioConvolverT<T>::_assign_buffers(const fftaArena &arena)
+{
+	m_filterSpectra = (T *)arena.at(m_filterSpectraAt);
+	m_delayLine = (T *)arena.at(m_delayLineAt);
+	m_accumulators = (T *)arena.at(m_accumulatorsAt);
+	m_timeBuffers = (T *)arena.at(m_timeBuffersAt);
+}
+
+
+/***************************************************************
+ ****************** Private Member Functions *******************
+ ***************************************************************/
+
+/***************************************************************
+ * FFTAudioConvolverT::_job_channel()
+ ***************************************************************/
+
+/*
+ * Filters the current block of one channel
+ */
+template<typename T>
+void
+FFTAudioConvolverT<T>::_job_channel(int thread_index, int channel)
+{
+	const size_t	stride = 2 * (size_t)m_spectrumStride;
+	const int		bins = m_blockSize + 1;
+	T				*frame = &this->m_inputBuffer[(size_t)this->getInputStride() * channel];
+	T				*delay_line = &m_delayLine[stride * m_partitionCount * channel];
+	const T			*filter = &m_filterSpectra[stride * m_partitionCount * m_channelFilter[channel]];
+	T				*acc = &m_accumulators[stride * thread_index];
+	T				*time = &m_timeBuffers[(size_t)this->getInputStride() * thread_index];
+	uint64_t		t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+	uint64_t		t1 = 0;
+	uint64_t		t2 = 0;
+
+	/*
+	 * The frame is the previous block followed by this one
+	 */
+	::memcpy(frame, &frame[m_blockSize], (size_t)m_blockSize * sizeof(T));
+	::memcpy(&frame[m_blockSize], m_processInput[channel], (size_t)m_blockSize * sizeof(T));
+
+	this->_forward_transform(frame, &delay_line[stride * m_delaySlot]);
+
+	if(this->_stats_enabled()) {
+		t1 = this->_stats_clock();
+	}
+
+	/*
+	 * Partition 'p' applies to the spectrum of 'p' blocks ago
+	 */
+	_complex_multiply(filter, &delay_line[stride * m_delaySlot], acc, bins);
+
+	for(int p = 1; p < m_partitionCount; ++p) {
+		int		slot = (m_delaySlot + m_partitionCount - p) % m_partitionCount;
+
+		_complex_multiply_accumulate(&filter[stride * p], &delay_line[stride * slot], acc, bins);
+	}
+
+	if(this->_stats_enabled()) {
+		t2 = this->_stats_clock();
+	}
+
+	/*
+	 * The first half of the circular convolution wraps around, the second half
+	 * is the linear convolution of this block
+	 */
+	this->_inverse_transform(acc, time);
+	::memcpy(m_processOutput[channel], &time[m_blockSize], (size_t)m_blockSize * sizeof(T));
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_stage(thread_index, FFTA_STATS_TRANSFORM, (t1 - t0) + (this->_stats_clock() - t2));
+		this->_stats_add_stage(thread_index, FFTA_STATS_POST_PROCESS, t2 - t1);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioConvolverT::_init_filter_spectra()
+ ***************************************************************/
+
+/*
+ * Transforms each 'block_size' partition of every filter, zero padded to the
+ * fft size.  The 1 / fft size scale of the inverse transform is folded in.
+ */
+template<typename T>
+void
+FFTAudioConvolverT<T>::_init_filter_spectra()
+{
+	const size_t	stride = 2 * (size_t)m_spectrumStride;
+	const T			scale = (T)1.0 / (T)(2 * m_blockSize);
+	T				*frame = m_timeBuffers;
+	int				first;
+	int				count;
+
+	for(size_t f = 0; f < m_filters.size(); ++f) {
+		const std::vector<T>	&taps = *m_filters[f];
+
+		for(int p = 0; p < m_partitionCount; ++p) {
+			first = p * m_blockSize;
+			count = (int)taps.size() - first;
+
+			if(count > m_blockSize) {
+				count = m_blockSize;
+			}
+
+			::memset(frame, 0, (size_t)this->getInputStride() * sizeof(T));
+
+			for(int i = 0; i < count; ++i) {
+				frame[i] = taps[first + i] * scale;
+			}
+
+			this->_forward_transform(frame, &m_filterSpectra[stride * ((f * m_partitionCount) + p)]);
+		}
+	}
+
+	::memset(frame, 0, (size_t)this->getInputStride() * sizeof(T));
+}
+
+
+/***************************************************************
+ * Explicit instantiations
+ ***************************************************************/
+
+template class FFTAudioConvolverT<float>;
+template class FFTAudioConvolverT<double>;
@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FFTA__CONVOLVER__H__
+#define FFTA__CONVOLVER__H__
+
+
+#include	<vector>
+
+#include	<fftaudio_status.h>
+#include	"fftaudio_fftw.h"
+
+
+//
+// Multi-channel FIR filtering by uniform partitioned convolution
+// (overlap-save), on the fftw plans, buffer arena and worker threads of
+// FFTAudioT.  Each filter is split into partitions of 'block_size' taps whose
+// spectra are computed once by initialize().  Every process() call then, for
+// each channel on the worker threads:
+//		1. transforms the last 2 * 'block_size' input samples
+//		2. stores the spectrum in the channel's frequency-domain delay line
+//		3. multiply-accumulates the delay line with the filter partitions
+//		4. transforms back and outputs the last 'block_size' samples
+// The output is the exact linear convolution of the input with the filter,
+// without latency beyond the block itself.  'T' is the floating point type,
+// use the FFTAudioConvolver and FFTAudioConvolverDouble typedefs.
+//
+template<typename T>
+class FFTAudioConvolverT : protected FFTAudioT<T>
+{
+public:
+	/*
+	 * FFTAudioConvolverT class constructor
+	 *		block_size - samples per channel of each process() call, the fft
+	 *			size is 2 * 'block_size' (most efficient when a power of two)
+	 *		channel_count - number of channels processed by each call
+	 */
+	FFTAudioConvolverT(int block_size, int channel_count = 1);
+
+	virtual ~FFTAudioConvolverT();
+
+	/*
+	 * initialize()
+	 *
+	 * Initialization function, must be called and succeed prior to calling
+	 * process().  Every channel must have a filter.
+	 *
+	 *	  Returns fftaStatus, any return value besides FFTA_SUCCESS indicates a
+	 *			failure occurred and the object becomes unuseable.
+	 */
+	virtual fftaStatus initialize();
+
+	/*
+	 * setFilter()
+	 *
+	 * Sets the impulse response of a channel.  Must be called before
+	 * initialize().  Channels sharing a filter share its partition spectra.
+	 *
+	 * channel - channel index, -1 sets the filter of every channel without
+	 *			one of its own
+	 * taps - array of 'tap_count' filter coefficients
+	 * tap_count - number of taps, the partition count of every channel is
+	 *			that of the longest filter
+	 *
+	 *	  Returns false if already initialized or an argument is invalid
+	 */
+	bool setFilter(int channel, const T *taps, int tap_count);
+
+	/*
+	 * process()
+	 *
+	 * Filters the next block of every channel
+	 *
+	 * input - 'channel_count' pointers to 'block_size' samples
+	 * output - 'channel_count' pointers to 'block_size' samples receiving the
+	 *			filtered signal, may be the same arrays as 'input'
+	 *
+	 *	  Returns false if not initialized
+	 */
+	bool process(const T *const *input, T *const *output);
+
+	/*
+	 * reset()
+	 *
+	 * Clears the input history, so the next block starts from silence
+	 */
+	void reset();
+
+	int getBlockSize() const						{ return m_blockSize;					}
+	int getChannelCount() const						{ return this->getBatchCount();			}
+	int getPartitionCount() const					{ return m_partitionCount;				}
+
+	/*
+	 * Worker thread, memory and statistics configuration, see FFTAudioT.
+	 * Channels are distributed across the workers.
+	 */
+	using FFTAudioT<T>::setWorkerCount;
+	using FFTAudioT<T>::getWorkerCount;
+	using FFTAudioT<T>::setWorkerAffinity;
+	using FFTAudioT<T>::setWorkerNode;
+	using FFTAudioT<T>::setRealtime;
+	using FFTAudioT<T>::setDispatchMode;
+	using FFTAudioT<T>::setPlannerEffort;
+	using FFTAudioT<T>::setHugePages;
+	using FFTAudioT<T>::getHugePages;
+	using FFTAudioT<T>::setStatsEnabled;
+	using FFTAudioT<T>::getStats;
+	using FFTAudioT<T>::resetStats;
+
+protected:
+	virtual void _reserve_buffers(fftaArena &arena, size_t alignment, int worker_count);
+	virtual void _assign_buffers(const fftaArena &arena);
+
+private:
+	void		_job_channel(int thread_index, int channel);
+	void		_init_filter_spectra();
+
+private:
+	int						m_blockSize = 0;
+	int						m_partitionCount = 0;
+
+	/*
+	 * Filter taps set with setFilter(), per channel and for channels without
+	 * their own.  initialize() maps each channel to one of the distinct
+	 * filters, 'm_channelFilter'.
+	 */
+	std::vector<std::vector<T>>	m_channelTaps;
+	std::vector<T>			m_defaultTaps;
+	std::vector<const std::vector<T> *>	m_filters;
+	std::vector<int>		m_channelFilter;
+
+	/*
+	 * Spectra are 'm_spectrumStride' complex values apart: the partitions of
+	 * each filter, the delay line of each channel ('m_partitionCount' spectra,
+	 * 'm_delaySlot' the newest) and one accumulator per worker.  Each worker
+	 * also has a real 'getInputStride()' buffer for the inverse transform.
+	 * The input history of each channel is its slice of the input buffer.
+	 */
+	int						m_spectrumStride = 0;
+	int						m_delaySlot = 0;
+	size_t					m_filterSpectraAt = 0;
+	size_t					m_delayLineAt = 0;
+	size_t					m_accumulatorsAt = 0;
+	size_t					m_timeBuffersAt = 0;
+	T						*m_filterSpectra = nullptr;
+	T						*m_delayLine = nullptr;
+	T						*m_accumulators = nullptr;
+	T						*m_timeBuffers = nullptr;
+
+	/*
+	 * Channel buffers of the running process() call
+	 */
+	const T *const			*m_processInput = nullptr;
+	T *const				*m_processOutput = nullptr;
+
+private:
+	FFTAudioConvolverT(const FFTAudioConvolverT &) = delete;
+	FFTAudioConvolverT &operator=(const FFTAudioConvolverT &) = delete;
+};
+
+
+extern template class FFTAudioConvolverT<float>;
+extern template class FFTAudioConvolverT<double>;
+
+typedef FFTAudioConvolverT<float>	FFTAudioConvolver;
+typedef FFTAudioConvolverT<double>	FFTAudioConvolverDouble;
+
+
+#endif // FFTA__CONVOLVER__H__
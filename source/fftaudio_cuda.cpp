@@ -67,6 +67,18 @@ FFTAudio::~FFTAudio()
 	if(m_outputBuffer != NULL) {
 		cudaFreeHost(m_outputBuffer);
 	}
+
+	if(m_postProcessBuffer != nullptr) {
+		::free(m_postProcessBuffer);
+	}
+
+	if(m_averageAccumulator != nullptr) {
+		::free(m_averageAccumulator);
+	}
+
+	if(m_targetBuffer != nullptr) {
+		::free(m_targetBuffer);
+	}
 }
 
 
@@ -85,6 +97,14 @@ FFTAudio::initialize()
 		return ret;
 	}
 
+	/*
+	 * Zoom (chirp-z) needs complex transforms, which this implementation lacks
+	 */
+	if(_uses_zoom()) {
+		m_initializeFailed = true;
+		return FFTA_UNSUPPORTED;
+	}
+
 	/*
 	 * Create cuda stream
 	 */
@@ -114,7 +134,7 @@ FFTAudio::initialize()
 	/*
 	 * Allocate output buffers on host and on cuda device
 	 */
-	alloc_sz = (size_t)(this->getBatchCount() * (this->getBinCount() + 1) * sizeof(cufftComplex));
+	alloc_sz = (size_t)(this->getBatchCount() * (this->_get_transform_bin_count() + 1) * sizeof(cufftComplex));
 
 	if(cudaMalloc((void **)&m_cudaOutputBuffer, alloc_sz) != cudaSuccess) {
 		m_initializeFailed = true;
@@ -129,6 +149,51 @@ FFTAudio::initialize()
 	cudaMemsetAsync(m_cudaOutputBuffer, 0, alloc_sz, m_stream);
 	::memset(m_outputBuffer, 0, alloc_sz);
 
+	/*
+	 * Target frequency results are computed on the host, with the Goertzel
+	 * algorithm or gathered from the fft output
+	 */
+	if(this->_has_target_frequencies()) {
+		m_targetBuffer = (cufftComplex *)::calloc((size_t)this->getBatchCount() * (this->getBinCount() + 1),
+												  sizeof(cufftComplex));
+		if(m_targetBuffer == nullptr) {
+			m_initializeFailed = true;
+			return FFTA_ALLOC_FAILED;
+		}
+	}
+
+	/*
+	 * Allocate host buffer for the output stages, computed on the host
+	 */
+	if(this->_get_post_process_size() > 0) {
+		alloc_sz = (size_t)this->getBatchCount() * this->_get_post_process_size() * sizeof(float);
+
+		m_postProcessBuffer = (float *)::calloc(1, alloc_sz);
+		if(m_postProcessBuffer == nullptr) {
+			m_initializeFailed = true;
+			return FFTA_ALLOC_FAILED;
+		}
+	}
+
+	/*
+	 * Averages are accumulated on the host by the thread calling execute()
+	 */
+	if(this->_is_averaging()) {
+		m_averageAccumulator = (float *)::calloc(this->_get_average_stride(), sizeof(float));
+		if(m_averageAccumulator == nullptr) {
+			m_initializeFailed = true;
+			return FFTA_ALLOC_FAILED;
+		}
+	}
+
+	/*
+	 * Statistics counters, batches run on the calling thread only
+	 */
+	if((ret = this->_init_stats(0)) != FFTA_SUCCESS) {
+		m_initializeFailed = true;
+		return ret;
+	}
+
 	/*
 	 * Create cuda plan
 	 */
@@ -149,49 +214,110 @@ FFTAudio::initialize()
 //////////////////////////////////////////////////////////////////////
 
 bool
-FFTAudio::execute(const short *data)
+FFTAudio::_execute(const inputDescriptor &input)
 {
-	std::vector<const short *>	data_ptrs;
+	if(!m_initialized || !input.isValid()) {
+		return false;
+	}
+
+	size_t				mem_sz;
+	const cufftComplex	*result = (m_targetBuffer != nullptr) ? m_targetBuffer : m_outputBuffer;
+	bool				stats = this->_stats_enabled();
+	uint64_t			start = stats ? this->_stats_clock() : 0;
+	uint64_t			t0 = start;
+	uint64_t			t1;
+
+	FFTA_ALLOC_CHECK_SCOPE();
 
 	for(int i = 0; i < this->getBatchCount(); ++i) {
-		data_ptrs.push_back(&data[i * this->getPaddedFrameSize()]);
+		this->_prepare_input_frame(input, i, &m_inputBuffer[i * this->getPaddedFrameSize()]);
 	}
 
-	return this->execute(data_ptrs.data());
-}
+	if(stats) {
+		t1 = this->_stats_clock();
+		this->_stats_add_stage(0, FFTA_STATS_CONVERT, t1 - t0);
+		t0 = t1;
+	}
 
+	if(this->usesGoertzel()) {
+		/*
+		 * A few target frequencies are cheaper to evaluate on the host than
+		 * the transfer to and from the device
+		 */
+		for(int i = 0; i < this->getBatchCount(); ++i) {
+			this->_goertzel_batch(&m_inputBuffer[i * this->getPaddedFrameSize()],
+								  (float *)&m_targetBuffer[i * (this->getBinCount() + 1)]);
+		}
 
-bool
-FFTAudio::execute(const short * const *data_ptrs)
-{
-	if(!m_initialized) {
-		return false;
+		if(stats) {
+			t1 = this->_stats_clock();
+			this->_stats_add_stage(0, FFTA_STATS_TRANSFORM, t1 - t0);
+			t0 = t1;
+		}
 	}
+	else {
+		/*
+		 * Copy input to device, execute, and copy output to host.
+		 * Synchronize the stream so output buffer is gauranteed to be populated before returning.
+		 */
+		mem_sz = (size_t)(this->getBatchCount() * this->getPaddedFrameSize() * sizeof(float));
+		cudaMemcpyAsync(&m_cudaInputBuffer[0], &m_inputBuffer[0], mem_sz, cudaMemcpyHostToDevice, m_stream);
 
-	int		frame_start_idx;
-	size_t	mem_sz;
+		cufftExecR2C(m_cudaPlan, m_cudaInputBuffer, m_cudaOutputBuffer);
 
-	for(int i = 0; i < this->getBatchCount(); ++i) {
-		frame_start_idx = i * this->getPaddedFrameSize();
+		mem_sz = (size_t)(this->getBatchCount() * (this->_get_transform_bin_count() + 1) * sizeof(cufftComplex));
+		cudaMemcpyAsync(&m_outputBuffer[0], &m_cudaOutputBuffer[0], mem_sz,  cudaMemcpyDeviceToHost, m_stream);
+
+		cudaStreamSynchronize(m_stream);
 
-		for(int j = 0; j < this->getFrameSize(); ++j) {
-			m_inputBuffer[frame_start_idx + j] = this->_prepare_input_value(j, data_ptrs[i][j]);
+		if(stats) {
+			t1 = this->_stats_clock();
+			this->_stats_add_stage(0, FFTA_STATS_TRANSFORM, t1 - t0);
+			t0 = t1;
+		}
+
+		if(m_targetBuffer != nullptr) {
+			for(int i = 0; i < this->getBatchCount(); ++i) {
+				this->_gather_targets((const float *)&m_outputBuffer[i * (this->_get_transform_bin_count() + 1)],
+									  (float *)&m_targetBuffer[i * (this->getBinCount() + 1)]);
+			}
 		}
 	}
 
-	/*
-	 * Copy input to device, execute, and copy output to host.
-	 * Synchronize the stream so output buffer is gauranteed to be populated before returning.
-	 */
-	mem_sz = (size_t)(this->getBatchCount() * this->getPaddedFrameSize() * sizeof(float));
-	cudaMemcpyAsync(&m_cudaInputBuffer[0], &m_inputBuffer[0], mem_sz, cudaMemcpyHostToDevice, m_stream);
+	if(this->_get_post_process_size() > 0) {
+		for(int i = 0; i < this->getBatchCount(); ++i) {
+			this->_post_process_batch((const float *)&result[i * (this->getBinCount() + 1)],
+									  &m_postProcessBuffer[i * this->_get_post_process_size()]);
+		}
+	}
 
-	cufftExecR2C(m_cudaPlan, m_cudaInputBuffer, m_cudaOutputBuffer);
+	if(this->_is_averaging()) {
+		for(int i = 0; i < this->getBatchCount(); ++i) {
+			this->_accumulate_average((const float *)&result[i * (this->getBinCount() + 1)],
+									  i, m_averageAccumulator);
+		}
+	}
 
-	mem_sz = (size_t)(this->getBatchCount() * (this->getBinCount() + 1) * sizeof(cufftComplex));
-	cudaMemcpyAsync(&m_outputBuffer[0], &m_cudaOutputBuffer[0], mem_sz,  cudaMemcpyDeviceToHost, m_stream);
+	if(stats) {
+		t1 = this->_stats_clock();
+		this->_stats_add_stage(0, FFTA_STATS_POST_PROCESS, t1 - t0);
+		t0 = t1;
+	}
+
+	if(this->_is_averaging()) {
+		this->_reduce_average(m_averageAccumulator, 1, 0, this->getBinCount() + 1);
+		this->_finish_average();
+
+		if(stats) {
+			t1 = this->_stats_clock();
+			this->_stats_add_stage(0, FFTA_STATS_REDUCE, t1 - t0);
+		}
+	}
+
+	if(stats) {
+		this->_stats_add_batch(this->_stats_clock() - start);
+	}
 
-	cudaStreamSynchronize(m_stream);
 	return true;
 }
 
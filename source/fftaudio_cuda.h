@@ -59,27 +59,38 @@ public:
 	 */
 	virtual fftaStatus initialize();
 
+protected:
 	/*
-	 * execute()
-	 *
-	 * Executes a batch of fft's
-	 *
-	 * data - Pointer to sample data (signed 16-bit), number of samples must equal
-	 *			'frame_size' * 'batch_count'.
-	 * data_ptrs - 'batch_count' array of pointers to sample data (signed 16-bit),
-	 *			each pointer must point to an array of 'frame_size' samples.
+	 * Converts the input, then copies it to the device, executes and copies
+	 * the output back to the host
 	 */
-	virtual bool execute(const short *data);
-	virtual bool execute(const short * const *data_ptrs);
+	virtual bool _execute(const inputDescriptor &input);
 
-protected:
 	/*
 	 * Returns real^2 + complex^2 of xufftComplex type at bin index 'bin_index'
 	 */
 	virtual float _get_complex_result(int idx) const
 	{
-		return ((m_outputBuffer[idx].x * m_outputBuffer[idx].x)
-					+ (m_outputBuffer[idx].y * m_outputBuffer[idx].y));
+		const cufftComplex	*result = (m_targetBuffer != nullptr) ? m_targetBuffer : m_outputBuffer;
+
+		return ((result[idx].x * result[idx].x) + (result[idx].y * result[idx].y));
+	}
+
+	/*
+	 * Returns the host cufftComplex output buffer (or the target frequency
+	 * results) as interleaved float pairs
+	 */
+	virtual const float *_get_complex_buffer() const
+	{
+		return (const float *)((m_targetBuffer != nullptr) ? m_targetBuffer : m_outputBuffer);
+	}
+
+	/*
+	 * Returns the host output stage buffer
+	 */
+	virtual const float *_get_post_process_buffer() const
+	{
+		return m_postProcessBuffer;
 	}
 
 private:
@@ -88,6 +99,9 @@ private:
 	float					*m_cudaInputBuffer = nullptr;
 	cufftComplex			*m_outputBuffer = nullptr;
 	cufftComplex			*m_cudaOutputBuffer = nullptr;
+	float					*m_postProcessBuffer = nullptr;
+	float					*m_averageAccumulator = nullptr;
+	cufftComplex			*m_targetBuffer = nullptr;
 };
 
 #endif // FFTA__CUDA__H__
@@ -16,38 +16,109 @@
 ///////////////////////////////////////////////////////////////////////////
 
 
+#include	<cerrno>
+#include	<cstdint>
+#include	<cstdio>
 #include	<cstdlib>
+#include	<cstring>
 #include	<vector>
 #include	<pthread.h>
+#include	<sched.h>
+#include	<strings.h>
+#include	<unistd.h>
+#include	<sys/mman.h>
 #include	<fftw3.h>
 
 #include	<fftaudio_status.h>
 #include	<fftaudio_fftw.h>
 
 
-pthread_mutex_t		FFTAudio::sm_planMutex = PTHREAD_MUTEX_INITIALIZER;
+/*
+ * fftwf_ and fftw_ keep separate planner state, so each precision has its own
+ * plan mutex and plan cache
+ */
+template<typename T>
+pthread_mutex_t		FFTAudioT<T>::sm_planMutex = PTHREAD_MUTEX_INITIALIZER;
+
+template<typename T>
+std::vector<typename FFTAudioT<T>::planEntry *>	FFTAudioT<T>::sm_planCache;
+
+template<typename T>
+bool				FFTAudioT<T>::sm_threadsInitialized = false;
+
+template<typename T>
+bool				FFTAudioT<T>::sm_environmentWisdomLoaded = false;
+
+/*
+ * Real-time instances of both precisions share one process-wide mlockall(),
+ * the last one destroyed releases it unless memory was already locked by the
+ * application when the first one took it
+ */
+static pthread_mutex_t	s_memoryLockMutex = PTHREAD_MUTEX_INITIALIZER;
+static int				s_memoryLockCount = 0;
+static bool				s_memoryLockRelease = false;
+
+
+/*
+ * Returns the VmLck of the process, in kB
+ */
+static unsigned long
+_locked_memory_kb()
+{
+	FILE			*fp;
+	char			line[128];
+	unsigned long	size_kb = 0;
+
+	if((fp = ::fopen("/proc/self/status", "r")) != nullptr) {
+		while(::fgets(line, sizeof(line), fp) != nullptr) {
+			if(::sscanf(line, "VmLck: %lu kB", &size_kb) == 1) {
+				break;
+			}
+		}
+
+		::fclose(fp);
+	}
+
+	return size_kb;
+}
 
 
 /***************************************************************
- * FFTAudio Constructor (fftw3)
+ * FFTAudioT Constructor (fftw3)
  ***************************************************************/
 
-FFTAudio::FFTAudio(FuncInitWindowCB window_type, int sample_rate,
-				   int frame_size, int padded_frame_size, int batch_count) :
-	FFTAudioBase(window_type, sample_rate, frame_size, padded_frame_size, batch_count)
+template<typename T>
+FFTAudioT<T>::FFTAudioT(FuncInitWindowCB window_type, int sample_rate,
+						int frame_size, int padded_frame_size, int batch_count) :
+	FFTAudioBaseT<T>(window_type, sample_rate, frame_size, padded_frame_size, batch_count)
 {
+	m_jobNextItem = 0;
+	CPU_ZERO(&m_allWorkerCpus);
 }
 
 
 /***************************************************************
- * FFTAudio Destructor (fftw3)
+ * FFTAudioT Destructor (fftw3)
  ***************************************************************/
 
-FFTAudio::~FFTAudio()
+template<typename T>
+FFTAudioT<T>::~FFTAudioT()
 {
-	m_done = -1;
-	pthread_cond_broadcast(&m_workCond);
-	pthread_mutex_unlock(&m_mutex);
+	this->_stop_coordinator();
+
+	if(m_dispatchMode == FFTA_DISPATCH_LOW_LATENCY) {
+		if(!m_tids.empty()) {
+			// Workers see the shutdown flag after passing the start barrier
+			m_shutdown = true;
+			m_barrier.wait(m_callerSense);
+		}
+	}
+	else {
+		::pthread_mutex_lock(&m_mutex);
+		m_shutdown = true;
+		::pthread_cond_broadcast(&m_workCond);
+		::pthread_mutex_unlock(&m_mutex);
+	}
 
 	for(size_t i = 0; i < m_tids.size(); ++i) {
 		::pthread_join(m_tids[i], NULL);
@@ -56,246 +127,1876 @@ FFTAudio::~FFTAudio()
 	::pthread_mutex_destroy(&m_mutex);
 	::pthread_cond_destroy(&m_workCond);
 	::pthread_cond_destroy(&m_ctrlCond);
+	::pthread_mutex_destroy(&m_asyncMutex);
+	::pthread_cond_destroy(&m_asyncCond);
 
 	/*
 	 * fftw create/destroy plan are not thread-safe, so plan destroys are wrapped with a static mutex
 	 */
 	::pthread_mutex_lock(&sm_planMutex);
-
-	for(size_t i = 0; i < m_fftwPlans.size(); ++i) {
-		/*
-		 * Destroy each existing plan
-		 */
-		fftwf_destroy_plan(m_fftwPlans.back());
-		m_fftwPlans.pop_back();
-	}
-
+	this->_destroy_plans();
 	::pthread_mutex_unlock(&sm_planMutex);
 
-	if(m_outputBuffer != nullptr) {
-		::fftwf_free(m_outputBuffer);
+	if(m_memoryLocked) {
+		this->_unlock_memory();
 	}
 
-	if(m_inputBuffer != nullptr) {
-		::fftwf_free(m_inputBuffer);
-	}
+	// Note: the buffers are carved from m_arena, which unmaps them
 }
 
 
 /***************************************************************
- * FFTAudio::initialize() (fftw3)
+ * FFTAudioT::initialize() (fftw3)
  ***************************************************************/
 
+template<typename T>
 fftaStatus
-FFTAudio::initialize()
+FFTAudioT<T>::initialize()
 {
 	fftaStatus		ret;
-	size_t			alloc_sz;
+	int				err;
 
-	if((ret = FFTAudioBase::initialize()) != FFTA_SUCCESS) {
+	if((ret = FFTAudioBaseT<T>::initialize()) != FFTA_SUCCESS) {
 		return ret;
 	}
 
 	/*
-	 * Allocate input buffer, one buffer shared by all threads
+	 * Resolve the number of worker threads: default to one worker per online
+	 * processor, never more than one per item of the largest job
+	 */
+	if(m_workerCount == 0) {
+		m_workerCount = (int)::sysconf(_SC_NPROCESSORS_ONLN);
+	}
+
+	if(m_workerCount > this->_get_max_job_items()) {
+		m_workerCount = this->_get_max_job_items();
+	}
+
+	if(m_workerCount < 1) {
+		m_workerCount = 1;
+	}
+
+	/*
+	 * Statistics counters, one slot per worker plus one for the thread
+	 * running the batch
 	 */
-	alloc_sz = (size_t)(this->getBatchCount() * this->getPaddedFrameSize() * sizeof(float));
+	ret = this->_init_stats(m_workerCount);
+
+	if(ret != FFTA_SUCCESS) {
+		this->m_initializeFailed = true;
+		return ret;
+	}
 
-	m_inputBuffer = (float *)::fftwf_malloc(alloc_sz);
-	if(m_inputBuffer == nullptr) {
-		m_initializeFailed = true;
-		return FFTA_ALLOC_FAILED;
+	ret = this->_allocate_buffers();
+
+	if(ret != FFTA_SUCCESS) {
+		this->m_initializeFailed = true;
+		return ret;
 	}
 
+	this->m_inputBuffer = m_bufferSets[0].bsm_inputBuffer;
+	m_outputBuffer = m_bufferSets[0].bsm_outputBuffer;
+	m_resultBuffer = m_outputBuffer;
+	m_resultPostProcess = m_bufferSets[0].bsm_postProcessBuffer;
+
 	/*
-	 * Allocate output buffer, one buffer shared by all threads
+	 * Start all threads and do initial synchronization
 	 */
-	alloc_sz = (size_t)(this->getBatchCount() * (this->getBinCount() + 1) * sizeof(fftwf_complex));
+	ret = this->_init_threads();
 
-	m_outputBuffer = (fftwf_complex *)fftwf_malloc(alloc_sz);
-	if(m_outputBuffer == nullptr) {
-		m_initializeFailed = true;
-		return FFTA_ALLOC_FAILED;
+	if(ret != FFTA_SUCCESS) {
+		this->m_initializeFailed = true;
+		return ret;
 	}
 
 	/*
-	 * fftw create/destroy plan are not thread-safe, so plan creates are wrapped with a static mutex
+	 * The buffers are cleared by the workers before anything else writes
+	 * them, so each page is first touched (and placed on the NUMA node of) the
+	 * worker that processes it
 	 */
-	::pthread_mutex_lock(&sm_planMutex);
+	this->_dispatch(&FFTAudioT::_job_first_touch, m_workerCount);
+	this->resetStats();
 
-	fftwf_plan	p;
+	/*
+	 * fftw create/destroy plan are not thread-safe, so plan creates are wrapped
+	 * with a static mutex.  Goertzel evaluation doesn't use a plan.
+	 */
+	if(!this->usesGoertzel()) {
+		::pthread_mutex_lock(&sm_planMutex);
+
+		_load_environment_wisdom();
+
+		ret = this->_create_plans(this->_get_planner_flags());
 
-	for(int i = 0; i < this->getBatchCount(); ++i) {
 		/*
-		 * Create and store an fftw plan for each batch/thread
+		 * FFTA_PLANNER_WISDOM_ONLY falls back to an estimated plan when no wisdom
+		 * exists for this configuration
 		 */
-		p = fftwf_plan_dft_r2c_1d(this->getPaddedFrameSize(),
-								  &m_inputBuffer[i * this->getPaddedFrameSize()],
-								  &m_outputBuffer[i * (this->getBinCount() + 1)], 0);
-		if(p == NULL) {
-			::pthread_mutex_unlock(&sm_planMutex);
-			m_initializeFailed = true;
-			return FFTA_PLAN_CREATE_FAILED;
+		if(ret != FFTA_SUCCESS && this->_get_planner_effort() == FFTA_PLANNER_WISDOM_ONLY) {
+			this->_destroy_plans();
+			ret = this->_create_plans(FFTW_ESTIMATE);
 		}
 
-		m_fftwPlans.push_back(p);
+		::pthread_mutex_unlock(&sm_planMutex);
+
+		if(ret != FFTA_SUCCESS) {
+			this->m_initializeFailed = true;
+			return ret;
+		}
 	}
 
-	::pthread_mutex_unlock(&sm_planMutex);
+	/*
+	 * The chirp-z filter is transformed once, with the forward plan
+	 */
+	if(this->_uses_zoom()) {
+		this->_init_zoom_filter((T *)m_zoomFilter);
+		fftaFftwTraits<T>::execute_dft(m_zoomForwardPlan->pdm_plan, m_zoomFilter, m_zoomFilter);
+	}
 
 	/*
-	 * Start all threads and do initial synchronization
+	 * Planning may overwrite the input buffer (when the plan isn't shared), clear
+	 * the input buffers so the zero padding beyond 'frame_size' in each batch is
+	 * valid
 	 */
-	ret = this->_init_threads();
+	for(size_t i = 0; i < m_bufferSets.size(); ++i) {
+		::memset(m_bufferSets[i].bsm_inputBuffer, 0, (size_t)this->getBatchCount() * m_inputStride * sizeof(T));
+	}
 
-	if(ret != FFTA_SUCCESS) {
-		m_initializeFailed = true;
-		return ret;
+	/*
+	 * Real-time mode locks everything execute() touches and starts the
+	 * coordinator now, so no later call faults in pages or creates a thread
+	 */
+	if(m_realtime) {
+		if(m_lockMemory && (err = this->_lock_memory()) != 0) {
+			this->m_initializeFailed = true;
+			return fftaStatus(FFTA_REALTIME_SETUP_FAILED, err);
+		}
+
+		if((err = this->_start_coordinator()) != 0) {
+			this->m_initializeFailed = true;
+			return fftaStatus(FFTA_REALTIME_SETUP_FAILED, err);
+		}
 	}
 
-	m_initialized = true;
+	this->m_initialized = true;
 	return FFTA_SUCCESS;
 }
 
 
 /***************************************************************
- * FFTAudio::execute()
+ * FFTAudioT::_execute()
  ***************************************************************/
 
+template<typename T>
 bool
-FFTAudio::execute(const short *data)
+FFTAudioT<T>::_execute(const inputDescriptor &input)
 {
-	std::vector<const short *>	data_ptrs;
+	bufferSet	*buffer_set;
 
-	for(int i = 0; i < this->getBatchCount(); ++i) {
-		data_ptrs.push_back(&data[i * this->getPaddedFrameSize()]);
+	if(!this->m_initialized || !input.isValid()) {
+		return false;
+	}
+
+	/*
+	 * Wait for queued batches, then run this one on the calling thread in the
+	 * next buffer set
+	 */
+	::pthread_mutex_lock(&m_asyncMutex);
+
+	while(m_completedTickets != m_nextTicket) {
+		::pthread_cond_wait(&m_asyncCond, &m_asyncMutex);
+	}
+
+	buffer_set = &m_bufferSets[m_nextTicket % m_bufferSets.size()];
+	buffer_set->bsm_boundInput = m_boundInput;
+	buffer_set->bsm_boundOutput = m_boundOutput;
+	::pthread_mutex_unlock(&m_asyncMutex);
+
+	this->_run_batch(*buffer_set, input);
+
+	::pthread_mutex_lock(&m_asyncMutex);
+	m_readyTickets = m_completedTickets = ++m_nextTicket;
+	::pthread_mutex_unlock(&m_asyncMutex);
+
+	m_resultBuffer = (buffer_set->bsm_boundOutput != nullptr) ? buffer_set->bsm_boundOutput : buffer_set->bsm_outputBuffer;
+	m_resultPostProcess = buffer_set->bsm_postProcessBuffer;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_execute_async()
+ ***************************************************************/
+
+template<typename T>
+int64_t
+FFTAudioT<T>::_execute_async(const inputDescriptor &input)
+{
+	int64_t		ticket;
+
+	if(!this->m_initialized || !input.isValid()) {
+		return -1;
+	}
+
+	/*
+	 * The coordinator thread is only started once executeAsync() is used
+	 */
+	if(!m_coordinatorStarted && this->_start_coordinator() != 0) {
+		return -1;
 	}
 
-	return this->execute(data_ptrs.data());
+	::pthread_mutex_lock(&m_asyncMutex);
+
+	/*
+	 * The buffer set is free once the batch submitted 'count' tickets ago
+	 * has completed
+	 */
+	while(m_nextTicket - m_completedTickets >= (int64_t)m_bufferSets.size()) {
+		::pthread_cond_wait(&m_asyncCond, &m_asyncMutex);
+	}
+
+	ticket = m_nextTicket++;
+	m_bufferSets[ticket % m_bufferSets.size()].bsm_input = input;
+	m_bufferSets[ticket % m_bufferSets.size()].bsm_boundInput = m_boundInput;
+	m_bufferSets[ticket % m_bufferSets.size()].bsm_boundOutput = m_boundOutput;
+
+	::pthread_cond_broadcast(&m_asyncCond);
+	::pthread_mutex_unlock(&m_asyncMutex);
+
+	return ticket;
 }
 
 
+/***************************************************************
+ * FFTAudioT::wait()
+ ***************************************************************/
+
+template<typename T>
 bool
-FFTAudio::execute(const short * const *data_ptrs)
+FFTAudioT<T>::wait(int64_t ticket)
 {
-	if(!m_initialized) {
+	::pthread_mutex_lock(&m_asyncMutex);
+
+	if(ticket < 0 || ticket >= m_nextTicket) {
+		::pthread_mutex_unlock(&m_asyncMutex);
 		return false;
 	}
 
-	m_done = 0;
-	m_inputDataPointers = data_ptrs;
+	while(m_completedTickets <= ticket) {
+		::pthread_cond_wait(&m_asyncCond, &m_asyncMutex);
+	}
+
+	::pthread_mutex_unlock(&m_asyncMutex);
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioT::selectResult()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioT<T>::selectResult(int64_t ticket)
+{
+	bool	ret;
+
+	::pthread_mutex_lock(&m_asyncMutex);
+
+	ret = (ticket >= 0 && ticket < m_readyTickets
+			&& ticket >= m_nextTicket - (int64_t)m_bufferSets.size());
+
+	if(ret) {
+		const bufferSet		&buffer_set = m_bufferSets[ticket % m_bufferSets.size()];
+
+		m_resultBuffer = (buffer_set.bsm_boundOutput != nullptr) ? buffer_set.bsm_boundOutput : buffer_set.bsm_outputBuffer;
+		m_resultPostProcess = buffer_set.bsm_postProcessBuffer;
+	}
+
+	::pthread_mutex_unlock(&m_asyncMutex);
+	return ret;
+}
+
+
+/***************************************************************
+ * FFTAudioT::bindBuffers()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioT<T>::bindBuffers(T *input, T *complex_out)
+{
+	fftwComplex		*output = (fftwComplex *)complex_out;
+
+	if(!this->m_initialized) {
+		return false;
+	}
 
 	/*
-	 * Wake up all threads
+	 * The plans are out-of-place, fftw results are undefined when the arrays
+	 * of an out-of-place plan overlap
 	 */
-	pthread_cond_broadcast(&m_workCond);
+	if(input != nullptr && complex_out != nullptr) {
+		const uintptr_t	in_begin = (uintptr_t)input;
+		const uintptr_t	in_end = in_begin + ((size_t)this->getBatchCount() * this->getInputStride() * sizeof(T));
+		const uintptr_t	out_begin = (uintptr_t)complex_out;
+		const uintptr_t	out_end = out_begin + ((size_t)this->getBatchCount() * this->getOutputStride() * 2 * sizeof(T));
+
+		if(in_begin < out_end && out_begin < in_end) {
+			return false;
+		}
+	}
 
 	/*
-	 * Wait for all threads to finish (m_done == m_tids.size)
+	 * Plans run per batch slice with the new-array interface, which needs the
+	 * alignment the plans were created with.  Zoom plans only use the work
+	 * buffers and target frequencies are transformed into m_transformBuffer.
 	 */
-	do {
-		// This condition is signaled when each work thread is done
-		pthread_cond_wait(&m_ctrlCond, &m_mutex);
-	} while(m_done < (int64_t)m_tids.size());
+	if(m_plan != nullptr && !m_unalignedPlans) {
+		if(!this->_is_simd_aligned(input, (m_transformBuffer == nullptr) ? output : nullptr)) {
+			return false;
+		}
+	}
 
-	m_inputDataPointers = nullptr;
+	m_boundInput = input;
+	m_boundOutput = output;
 	return true;
 }
 
 
 /***************************************************************
- ****************** Private Member Functions *******************
+ * FFTAudioT::setAsyncBufferCount()
  ***************************************************************/
 
+template<typename T>
+bool
+FFTAudioT<T>::setAsyncBufferCount(int buffer_count)
+{
+	if(this->m_initialized || this->m_initializeFailed || buffer_count < 1) {
+		return false;
+	}
+
+	m_asyncBufferCount = buffer_count;
+	return true;
+}
+
+
 /***************************************************************
- * FFTAudio::run()
+ * FFTAudioT::setWorkerCount()
  ***************************************************************/
 
-void
-FFTAudio::_run(int thread_index)
+template<typename T>
+bool
+FFTAudioT<T>::setWorkerCount(int worker_count)
 {
-	int		frame_start_idx;
+	if(this->m_initialized || this->m_initializeFailed || worker_count < 0) {
+		return false;
+	}
 
-	::pthread_mutex_lock(&m_mutex);
-	++m_done;
-	pthread_cond_signal(&m_ctrlCond);
+	m_workerCount = worker_count;
+	return true;
+}
 
-	do {
-		do {
-			pthread_cond_wait(&m_workCond, &m_mutex);
-		} while(m_inputDataPointers == nullptr && m_done != -1);
 
-		pthread_mutex_unlock(&m_mutex);
+/***************************************************************
+ * FFTAudioT::setRealtime()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioT<T>::setRealtime(int priority, bool lock_memory)
+{
+	if(this->m_initialized || this->m_initializeFailed) {
+		return false;
+	}
 
-		if(m_done == -1) {
-			break;
-		}
+	if(priority != 0 && (priority < ::sched_get_priority_min(SCHED_FIFO)
+						 || priority > ::sched_get_priority_max(SCHED_FIFO))) {
+		return false;
+	}
+
+	m_realtime = true;
+	m_realtimePriority = priority;
+	m_lockMemory = lock_memory;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioT::setWorkerAffinity() / FFTAudioT::setWorkerNode()
+ ***************************************************************/
 
-		frame_start_idx = this->getPaddedFrameSize() * thread_index;
+template<typename T>
+bool
+FFTAudioT<T>::setWorkerAffinity(int worker_index, const cpu_set_t &cpus)
+{
+	if(this->m_initialized || this->m_initializeFailed || worker_index < -1 || CPU_COUNT(&cpus) == 0) {
+		return false;
+	}
 
-		for(int i = 0; i < this->getFrameSize(); ++i) {			
-			m_inputBuffer[frame_start_idx + i] = _prepare_input_value(i, m_inputDataPointers[thread_index][i]);
+	if(worker_index == -1) {
+		m_allWorkerCpus = cpus;
+	}
+	else {
+		if((size_t)worker_index >= m_workerCpus.size()) {
+			cpu_set_t	unbound;
+
+			CPU_ZERO(&unbound);
+			m_workerCpus.resize(worker_index + 1, unbound);
 		}
 
-		fftwf_execute(m_fftwPlans[thread_index]);
+		m_workerCpus[worker_index] = cpus;
+	}
 
-		pthread_mutex_lock(&m_mutex);
-		++m_done;
-		pthread_cond_signal(&m_ctrlCond);
-	} while(true);
+	m_staticSchedule = true;
+	return true;
 }
 
 
-/*
- * Static work thread main() function
- */
-void *
-FFTAudio::_ffta_fftw_main(void *arg)
-{	
-	threadArgument	*thr_data = (threadArgument *)arg;
-	FFTAudio		*ffta = thr_data->tdm_ffta;
-	int				thr_idx = thr_data->tdm_threadIndex;
+template<typename T>
+bool
+FFTAudioT<T>::setWorkerNode(int worker_index, int node)
+{
+	char		path[128];
+	char		list[4096];
+	FILE		*fp;
+	cpu_set_t	cpus;
+	char		*p;
+	char		*end;
+	long		first;
+	long		last;
+
+	if(node < 0) {
+		return false;
+	}
 
-	delete thr_data;
+	/*
+	 * The node's cpus are listed as ranges, e.g. "0-7,16-23"
+	 */
+	::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
 
-	ffta->_run(thr_idx);
-	return nullptr;
+	if((fp = ::fopen(path, "r")) == nullptr) {
+		return false;
+	}
+
+	p = ::fgets(list, sizeof(list), fp);
+	::fclose(fp);
+
+	if(p == nullptr) {
+		return false;
+	}
+
+	CPU_ZERO(&cpus);
+
+	while(*p != '\0' && *p != '\n') {
+		first = ::strtol(p, &end, 10);
+		if(end == p) {
+			return false;
+		}
+
+		last = first;
+		p = end;
+
+		if(*p == '-') {
+			last = ::strtol(p + 1, &end, 10);
+			p = end;
+		}
+
+		for(long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+			CPU_SET(cpu, &cpus);
+		}
+
+		if(*p == ',') {
+			++p;
+		}
+	}
+
+	return this->setWorkerAffinity(worker_index, cpus);
 }
 
 
 /***************************************************************
- * FFTAudio::_init_threads()
+ * FFTAudioT::setSliceAlignment() / FFTAudioT::setHugePages()
  ***************************************************************/
 
-/*
- * Called by initialization function to perform thread creation
- */
-fftaStatus
-FFTAudio::_init_threads()
+template<typename T>
+bool
+FFTAudioT<T>::setSliceAlignment(int bytes)
 {
-	pthread_t		tid;
-	threadArgument	*thr_arg;
+	if(this->m_initialized || this->m_initializeFailed) {
+		return false;
+	}
 
-	::pthread_mutex_lock(&m_mutex);
+	if(bytes != 0 && (bytes < FFTAudioBaseT<T>::AVERAGE_ALIGNMENT || (bytes & (bytes - 1)) != 0)) {
+		return false;
+	}
 
-	for(int i = 0; i < this->getBatchCount(); ++i) {
-		thr_arg = new threadArgument(this, i);
+	this->_set_slice_alignment(bytes);
+	return true;
+}
 
-		if(::pthread_create(&tid, nullptr, _ffta_fftw_main, thr_arg) != 0) {
-			::pthread_mutex_unlock(&m_mutex);
-			delete thr_arg;
-			return FFTA_THREAD_CREATE_FAILED;
-		}
 
-		m_tids.push_back(tid);
+template<typename T>
+bool
+FFTAudioT<T>::setHugePages(fftaHugePageMode mode)
+{
+	if(this->m_initialized || this->m_initializeFailed) {
+		return false;
 	}
 
-	m_done = 0;
+	m_hugePages = mode;
+	return true;
+}
 
-	do {
-		::pthread_cond_wait(&m_ctrlCond, &m_mutex);
-	} while(m_done < (int64_t)m_tids.size());
 
-	return FFTA_SUCCESS;
+/***************************************************************
+ * FFTAudioT::setDispatchMode()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioT<T>::setDispatchMode(fftaDispatchMode mode, int spin_count)
+{
+	if(this->m_initialized || this->m_initializeFailed) {
+		return false;
+	}
+
+	m_dispatchMode = mode;
+	m_spinCount = (spin_count < 0) ? 0 : spin_count;
+	return true;
 }
 
+
+/***************************************************************
+ * FFTAudioT::setPlanMode()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioT<T>::setPlanMode(fftaPlanMode mode, int plan_threads)
+{
+	if(this->m_initialized || this->m_initializeFailed || plan_threads < 0) {
+		return false;
+	}
+
+	m_planMode = mode;
+	m_planThreads = plan_threads;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioT::setPlannerEffort()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioT<T>::setPlannerEffort(fftaPlannerEffort effort)
+{
+	if(this->m_initialized || this->m_initializeFailed) {
+		return false;
+	}
+
+	m_plannerEffort = effort;
+	m_plannerEffortSet = true;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioT::loadWisdom() / FFTAudioT::saveWisdom()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioT<T>::loadWisdom(const char *filename)
+{
+	int		ret;
+
+	::pthread_mutex_lock(&sm_planMutex);
+	ret = fftaFftwTraits<T>::import_wisdom(filename);
+	::pthread_mutex_unlock(&sm_planMutex);
+
+	return (ret != 0);
+}
+
+
+template<typename T>
+bool
+FFTAudioT<T>::saveWisdom(const char *filename)
+{
+	int		ret;
+
+	::pthread_mutex_lock(&sm_planMutex);
+	ret = fftaFftwTraits<T>::export_wisdom(filename);
+	::pthread_mutex_unlock(&sm_planMutex);
+
+	return (ret != 0);
+}
+
+
+/***************************************************************
+ ****************** Private Member Functions *******************
+ ***************************************************************/
+
+/***************************************************************
+ * FFTAudioT::_get_planner_effort()
+ ***************************************************************/
+
+/*
+ * Returns the planner effort set with setPlannerEffort(), otherwise the one
+ * named by the FFTA_PLANNER_EFFORT environment variable, otherwise
+ * FFTA_PLANNER_MEASURE
+ */
+template<typename T>
+fftaPlannerEffort
+FFTAudioT<T>::_get_planner_effort() const
+{
+	const char	*env;
+
+	if(m_plannerEffortSet) {
+		return m_plannerEffort;
+	}
+
+	env = ::getenv("FFTA_PLANNER_EFFORT");
+	if(env == nullptr) {
+		return FFTA_PLANNER_MEASURE;
+	}
+
+	if(::strcasecmp(env, "estimate") == 0) {
+		return FFTA_PLANNER_ESTIMATE;
+	}
+	else if(::strcasecmp(env, "patient") == 0) {
+		return FFTA_PLANNER_PATIENT;
+	}
+	else if(::strcasecmp(env, "exhaustive") == 0) {
+		return FFTA_PLANNER_EXHAUSTIVE;
+	}
+	else if(::strcasecmp(env, "wisdom_only") == 0) {
+		return FFTA_PLANNER_WISDOM_ONLY;
+	}
+
+	return FFTA_PLANNER_MEASURE;
+}
+
+
+/*
+ * Returns the fftw planner flags for the planner effort
+ */
+template<typename T>
+unsigned
+FFTAudioT<T>::_get_planner_flags() const
+{
+	switch(this->_get_planner_effort()) {
+	case FFTA_PLANNER_ESTIMATE:
+		return FFTW_ESTIMATE;
+
+	case FFTA_PLANNER_PATIENT:
+		return FFTW_PATIENT;
+
+	case FFTA_PLANNER_EXHAUSTIVE:
+		return FFTW_EXHAUSTIVE;
+
+	case FFTA_PLANNER_WISDOM_ONLY:
+		return FFTW_WISDOM_ONLY;
+
+	default:
+		break;
+	}
+
+	return FFTW_MEASURE;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_load_environment_wisdom()
+ ***************************************************************/
+
+/*
+ * Imports the wisdom file named by the FFTA_WISDOM_FILE (float) or
+ * FFTA_WISDOM_FILE_DOUBLE (double) environment variable, once per process.
+ * The precisions can't share a file, fftw's wisdom formats differ.  Called
+ * with sm_planMutex held.
+ */
+template<typename T>
+void
+FFTAudioT<T>::_load_environment_wisdom()
+{
+	const char	*env;
+
+	if(sm_environmentWisdomLoaded) {
+		return;
+	}
+
+	sm_environmentWisdomLoaded = true;
+
+	env = ::getenv(fftaFftwTraits<T>::wisdom_variable());
+	if(env != nullptr && env[0] != '\0' && !fftaFftwTraits<T>::import_wisdom(env)) {
+		/*
+		 * Plans are still created, just without the wisdom
+		 */
+		::fprintf(stderr, "fftaudio: failed to import %s wisdom from '%s'\n",
+				  fftaFftwTraits<T>::wisdom_variable(), env);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioT::_dispatch()
+ ***************************************************************/
+
+/*
+ * Runs 'job_func' for items 0 --> 'item_count' - 1 on the worker threads and
+ * waits for all of them to finish
+ */
+template<typename T>
+void
+FFTAudioT<T>::_dispatch(FuncJob job_func, int item_count)
+{
+	uint64_t	start = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	/*
+	 * Claim a few items at a time so large batch counts don't contend on the
+	 * shared counter, while still leaving enough chunks to balance the load
+	 */
+	m_jobChunk = item_count / (int)(m_tids.size() * 4);
+	if(m_jobChunk < 1) {
+		m_jobChunk = 1;
+	}
+
+	m_jobFunc = job_func;
+	m_jobItemCount = item_count;
+	m_jobNextItem.store(0, std::memory_order_relaxed);
+
+	if(m_dispatchMode == FFTA_DISPATCH_LOW_LATENCY) {
+		/*
+		 * Start barrier releases the workers, end barrier completes when the
+		 * last worker has finished its share of the job
+		 */
+		m_barrier.wait(m_callerSense);
+		m_barrier.wait(m_callerSense);
+	}
+	else {
+		::pthread_mutex_lock(&m_mutex);
+
+		m_activeWorkers = m_tids.size();
+		++m_workGeneration;
+
+		/*
+		 * Wake up all threads
+		 */
+		::pthread_cond_broadcast(&m_workCond);
+
+		/*
+		 * Wait for all threads to finish
+		 */
+		while(m_activeWorkers > 0) {
+			// This condition is signaled when the last work thread is done
+			::pthread_cond_wait(&m_ctrlCond, &m_mutex);
+		}
+
+		::pthread_mutex_unlock(&m_mutex);
+	}
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_stage(m_workerCount, FFTA_STATS_WAIT, this->_stats_clock() - start);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioT::_run_job()
+ ***************************************************************/
+
+/*
+ * Claims and processes chunks of the current job until none are left
+ *
+ *	  Returns the number of items processed
+ */
+template<typename T>
+int
+FFTAudioT<T>::_run_job(int thread_index)
+{
+	int		item_idx;
+	int		item_end;
+	int		processed = 0;
+
+	FFTA_ALLOC_CHECK_SCOPE();
+
+	if(m_staticSchedule) {
+		this->_get_static_range(m_jobItemCount, thread_index, item_idx, item_end);
+
+		for(processed = item_end - item_idx; item_idx < item_end; ++item_idx) {
+			(this->*m_jobFunc)(thread_index, item_idx);
+		}
+
+		return processed;
+	}
+
+	while((item_idx = m_jobNextItem.fetch_add(m_jobChunk, std::memory_order_relaxed)) < m_jobItemCount) {
+		item_end = item_idx + m_jobChunk;
+		if(item_end > m_jobItemCount) {
+			item_end = m_jobItemCount;
+		}
+
+		processed += item_end - item_idx;
+
+		for(; item_idx < item_end; ++item_idx) {
+			(this->*m_jobFunc)(thread_index, item_idx);
+		}
+	}
+
+	return processed;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_run_batch()
+ ***************************************************************/
+
+/*
+ * Converts and transforms one batch of input into 'buffer_set', called by
+ * execute() or the coordinator thread
+ */
+template<typename T>
+void
+FFTAudioT<T>::_run_batch(bufferSet &buffer_set, const inputDescriptor &input)
+{
+	uint64_t	start = this->_stats_enabled() ? this->_stats_clock() : 0;
+	uint64_t	t0;
+
+	FFTA_ALLOC_CHECK_SCOPE();
+
+	m_input = &input;
+	m_workInputBound = (buffer_set.bsm_boundInput != nullptr);
+	m_workInputBuffer = m_workInputBound ? buffer_set.bsm_boundInput : buffer_set.bsm_inputBuffer;
+	m_workOutputBuffer = (buffer_set.bsm_boundOutput != nullptr) ? buffer_set.bsm_boundOutput : buffer_set.bsm_outputBuffer;
+	m_workPostProcess = buffer_set.bsm_postProcessBuffer;
+
+	if(m_plan != nullptr && m_plan->pdm_planMode == FFTA_PLAN_BATCHED) {
+		/*
+		 * Convert every batch on the worker threads, then transform all of
+		 * them with the single batched plan (which uses fftw's own threads),
+		 * then run the output stages on the worker threads
+		 */
+		this->_dispatch(&FFTAudioT::_job_convert, this->getBatchCount());
+
+		t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+		fftaFftwTraits<T>::execute_dft_r2c(m_plan->pdm_plan, m_workInputBuffer,
+										   (m_transformBuffer != nullptr) ? m_transformBuffer : m_workOutputBuffer);
+
+		if(this->_stats_enabled()) {
+			this->_stats_add_stage(m_workerCount, FFTA_STATS_TRANSFORM, this->_stats_clock() - t0);
+		}
+
+		if(this->_has_post_process_job()) {
+			this->_dispatch(&FFTAudioT::_job_post_process, this->getBatchCount());
+		}
+	}
+	else {
+		/*
+		 * Convert and transform (or Goertzel evaluate) every batch on the
+		 * worker threads
+		 */
+		this->_dispatch(&FFTAudioT::_job_batch, this->getBatchCount());
+	}
+
+	/*
+	 * Each worker accumulated the batches it claimed, merge the accumulators
+	 * one range of bins per item
+	 */
+	if(this->_is_averaging()) {
+		this->_dispatch(&FFTAudioT::_job_reduce_average,
+						(this->getBinCount() + AVERAGE_REDUCE_CHUNK) / AVERAGE_REDUCE_CHUNK);
+
+		t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+		this->_finish_average();
+
+		if(this->_stats_enabled()) {
+			this->_stats_add_stage(m_workerCount, FFTA_STATS_REDUCE, this->_stats_clock() - t0);
+		}
+	}
+
+	m_input = nullptr;
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_batch(this->_stats_clock() - start);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioT::_job_convert()
+ ***************************************************************/
+
+/*
+ * Converts the input samples of one batch into the input buffer
+ */
+template<typename T>
+void
+FFTAudioT<T>::_job_convert(int thread_index, int batch_index)
+{
+	T			*frame = &m_workInputBuffer[(size_t)m_inputStride * batch_index];
+	uint64_t	t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	this->_prepare_input_frame(*m_input, batch_index, frame);
+
+	/*
+	 * Engine input buffers keep the zero padding from initialize(), caller
+	 * buffers may hold anything beyond 'frame_size'
+	 */
+	if(m_workInputBound && this->getPaddedFrameSize() > this->getFrameSize()) {
+		::memset(&frame[this->getFrameSize()], 0, (size_t)(this->getPaddedFrameSize() - this->getFrameSize()) * sizeof(T));
+	}
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_stage(thread_index, FFTA_STATS_CONVERT, this->_stats_clock() - t0);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioT::_job_batch()
+ ***************************************************************/
+
+/*
+ * Converts the input samples of one batch, executes its fft plan and runs the
+ * output stages
+ */
+template<typename T>
+void
+FFTAudioT<T>::_job_batch(int thread_index, int batch_index)
+{
+	T			*input = &m_workInputBuffer[(size_t)m_inputStride * batch_index];
+	fftwComplex	*output = &m_workOutputBuffer[(size_t)this->_get_output_stride() * batch_index];
+	uint64_t	t0;
+
+	this->_job_convert(thread_index, batch_index);
+
+	t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	if(this->usesGoertzel()) {
+		this->_goertzel_batch(input, (T *)output);
+	}
+	else if(this->_uses_zoom()) {
+		fftwComplex		*work = &m_zoomWorkBuffer[(size_t)m_zoomStride * thread_index];
+
+		this->_zoom_premultiply(input, (T *)work);
+		fftaFftwTraits<T>::execute_dft(m_zoomForwardPlan->pdm_plan, work, work);
+		this->_zoom_convolve((T *)work, (const T *)m_zoomFilter);
+		fftaFftwTraits<T>::execute_dft(m_zoomBackwardPlan->pdm_plan, work, work);
+		this->_zoom_postmultiply((const T *)work, (T *)output);
+	}
+	else if(m_transformBuffer != nullptr) {
+		fftaFftwTraits<T>::execute_dft_r2c(m_plan->pdm_plan, input, &m_transformBuffer[(size_t)m_transformStride * batch_index]);
+	}
+	else {
+		fftaFftwTraits<T>::execute_dft_r2c(m_plan->pdm_plan, input, output);
+	}
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_stage(thread_index, FFTA_STATS_TRANSFORM, this->_stats_clock() - t0);
+	}
+
+	if(this->_has_post_process_job()) {
+		this->_job_post_process(thread_index, batch_index);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioT::_job_post_process()
+ ***************************************************************/
+
+/*
+ * Gathers the target bins of one batch from the fft output and runs its
+ * output stages
+ */
+template<typename T>
+void
+FFTAudioT<T>::_job_post_process(int thread_index, int batch_index)
+{
+	const T		*complex_in = (const T *)&m_workOutputBuffer[(size_t)this->_get_output_stride() * batch_index];
+	uint64_t	t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	if(m_transformBuffer != nullptr) {
+		this->_gather_targets((const T *)&m_transformBuffer[(size_t)m_transformStride * batch_index],
+							  (T *)complex_in);
+	}
+
+	if(this->_get_post_process_size() > 0) {
+		this->_post_process_batch(complex_in, &m_workPostProcess[(size_t)this->_get_post_process_stride() * batch_index]);
+	}
+
+	if(this->_is_averaging()) {
+		this->_accumulate_average(complex_in, batch_index,
+								  &m_averageAccumulators[(size_t)this->_get_average_stride() * thread_index]);
+	}
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_stage(thread_index, FFTA_STATS_POST_PROCESS, this->_stats_clock() - t0);
+	}
+}
+
+
+/*
+ * Returns true if batches need _job_post_process() after the fft
+ */
+template<typename T>
+bool
+FFTAudioT<T>::_has_post_process_job() const
+{
+	return (this->_get_post_process_size() > 0 || this->_is_averaging() || m_transformBuffer != nullptr);
+}
+
+
+/***************************************************************
+ * FFTAudioT::_job_reduce_average()
+ ***************************************************************/
+
+/*
+ * Merges one range of bins of every worker's average accumulator
+ */
+template<typename T>
+void
+FFTAudioT<T>::_job_reduce_average(int thread_index, int chunk_index)
+{
+	int			first_bin = chunk_index * AVERAGE_REDUCE_CHUNK;
+	int			count = this->getBinCount() + 1 - first_bin;
+	uint64_t	t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	if(count > AVERAGE_REDUCE_CHUNK) {
+		count = AVERAGE_REDUCE_CHUNK;
+	}
+
+	this->_reduce_average(m_averageAccumulators, m_workerCount, first_bin, count);
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_stage(thread_index, FFTA_STATS_REDUCE, this->_stats_clock() - t0);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioT::_job_first_touch()
+ ***************************************************************/
+
+/*
+ * Clears the buffer slices worker 'owner_index' processes: its share of the
+ * batches of every buffer set under the static schedule (or the same share
+ * when batches are claimed dynamically), and its own work buffers
+ */
+template<typename T>
+void
+FFTAudioT<T>::_job_first_touch(int thread_index, int owner_index)
+{
+	size_t		input_sz = (size_t)m_inputStride;
+	size_t		output_sz = (size_t)this->_get_output_stride();
+	size_t		post_sz = (size_t)this->_get_post_process_stride();
+	size_t		transform_sz = (size_t)m_transformStride;
+	int			first;
+	int			end;
+
+	this->_get_static_range(this->getBatchCount(), owner_index, first, end);
+
+	for(size_t i = 0; i < m_bufferSets.size(); ++i) {
+		::memset(&m_bufferSets[i].bsm_inputBuffer[input_sz * first], 0, input_sz * (end - first) * sizeof(T));
+		::memset(&m_bufferSets[i].bsm_outputBuffer[output_sz * first], 0, output_sz * (end - first) * sizeof(fftwComplex));
+
+		if(post_sz > 0) {
+			::memset(&m_bufferSets[i].bsm_postProcessBuffer[post_sz * first], 0, post_sz * (end - first) * sizeof(T));
+		}
+	}
+
+	if(m_transformBuffer != nullptr) {
+		::memset(&m_transformBuffer[transform_sz * first], 0, transform_sz * (end - first) * sizeof(fftwComplex));
+	}
+
+	if(m_averageAccumulators != nullptr) {
+		::memset(&m_averageAccumulators[(size_t)this->_get_average_stride() * owner_index], 0,
+				 (size_t)this->_get_average_stride() * sizeof(T));
+	}
+
+	if(m_zoomWorkBuffer != nullptr) {
+		::memset(&m_zoomWorkBuffer[(size_t)m_zoomStride * owner_index], 0, (size_t)m_zoomStride * sizeof(fftwComplex));
+	}
+}
+
+
+/*
+ * Returns the items 'first' --> 'end' - 1 of 'item_count' worker
+ * 'thread_index' runs under the static schedule
+ */
+template<typename T>
+void
+FFTAudioT<T>::_get_static_range(int item_count, int thread_index, int &first, int &end) const
+{
+	first = (int)(((int64_t)item_count * thread_index) / m_workerCount);
+	end = (int)(((int64_t)item_count * (thread_index + 1)) / m_workerCount);
+}
+
+
+/***************************************************************
+ * FFTAudioT::_forward_transform() / FFTAudioT::_inverse_transform()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioT<T>::_forward_transform(T *in, T *complex_out) const
+{
+	fftaFftwTraits<T>::execute_dft_r2c(m_plan->pdm_plan, in, (fftwComplex *)complex_out);
+}
+
+
+template<typename T>
+void
+FFTAudioT<T>::_inverse_transform(T *complex_in, T *out) const
+{
+	fftaFftwTraits<T>::execute_dft_c2r(m_inversePlan->pdm_plan, (fftwComplex *)complex_in, out);
+}
+
+
+/***************************************************************
+ * FFTAudioT::_create_plans()
+ ***************************************************************/
+
+/*
+ * Acquires the shared plans for the configured plan mode.  Called with
+ * sm_planMutex held.
+ *
+ * FFTA_PLAN_PER_BATCH uses one single-transform plan for every batch,
+ * FFTA_PLAN_BATCHED one advanced-interface plan covering all batches.  Zoom
+ * (chirp-z) uses a forward and a backward in-place complex plan of the zoom
+ * length, run per batch on the worker's own work buffer.  Plans are executed
+ * with the new-array interface, so any buffer whose alignment differs from
+ * fftw's simd alignment needs an FFTW_UNALIGNED plan.
+ */
+template<typename T>
+fftaStatus
+FFTAudioT<T>::_create_plans(unsigned flags)
+{
+	int		n = this->getPaddedFrameSize();
+	int		how_many = 1;
+	int		threads = 1;
+
+	m_unalignedPlans = !this->_is_simd_aligned();
+
+	if(m_unalignedPlans) {
+		flags |= FFTW_UNALIGNED;
+	}
+
+	if(this->_uses_zoom()) {
+		n = this->_get_zoom_length();
+
+		m_zoomForwardPlan = this->_acquire_plan(planEntry::PLAN_C2C_FORWARD, n, 1, m_zoomStride, m_zoomStride, 1, flags);
+		m_zoomBackwardPlan = this->_acquire_plan(planEntry::PLAN_C2C_BACKWARD, n, 1, m_zoomStride, m_zoomStride, 1, flags);
+
+		if(m_zoomForwardPlan == nullptr || m_zoomBackwardPlan == nullptr) {
+			return FFTA_PLAN_CREATE_FAILED;
+		}
+
+		return FFTA_SUCCESS;
+	}
+
+	if(m_planMode == FFTA_PLAN_BATCHED) {
+		how_many = this->getBatchCount();
+		threads = (m_planThreads == 0) ? m_workerCount : m_planThreads;
+	}
+
+	m_plan = this->_acquire_plan(planEntry::PLAN_R2C, n, how_many, m_inputStride, m_transformStride, threads, flags);
+
+	if(m_plan == nullptr) {
+		return FFTA_PLAN_CREATE_FAILED;
+	}
+
+	if(m_inverseTransform) {
+		m_inversePlan = this->_acquire_plan(planEntry::PLAN_C2R, n, 1, m_transformStride, m_inputStride, 1, flags);
+
+		if(m_inversePlan == nullptr) {
+			return FFTA_PLAN_CREATE_FAILED;
+		}
+	}
+
+	return FFTA_SUCCESS;
+}
+
+
+/*
+ * Returns the cached plan matching the arguments, creating it if no other
+ * instance uses the same configuration.  Called with sm_planMutex held.
+ *
+ *	  Returns nullptr if the plan could not be created
+ */
+template<typename T>
+typename FFTAudioT<T>::planEntry *
+FFTAudioT<T>::_acquire_plan(int kind, int n, int how_many, int in_distance, int out_distance,
+							int threads, unsigned flags)
+{
+	fftwPlan		p;
+	fftwComplex		*out = (m_transformBuffer != nullptr) ? m_transformBuffer : m_outputBuffer;
+	planEntry		*entry;
+	fftaPlanMode	mode = (how_many > 1 || threads > 1) ? FFTA_PLAN_BATCHED : m_planMode;
+
+	for(size_t i = 0; i < sm_planCache.size(); ++i) {
+		entry = sm_planCache[i];
+
+		if(entry->pdm_kind == kind && entry->pdm_planMode == mode && entry->pdm_size == n
+				&& entry->pdm_howMany == how_many
+				&& entry->pdm_inputDistance == in_distance
+				&& entry->pdm_outputDistance == out_distance
+				&& entry->pdm_threads == threads && entry->pdm_flags == flags) {
+			entry->pdm_refCount++;
+			return entry;
+		}
+	}
+
+	if(kind == planEntry::PLAN_C2R) {
+		p = fftaFftwTraits<T>::plan_dft_c2r_1d(n, out, this->m_inputBuffer, flags);
+	}
+	else if(kind != planEntry::PLAN_R2C) {
+		p = fftaFftwTraits<T>::plan_dft_1d(n, m_zoomWorkBuffer, m_zoomWorkBuffer,
+										   (kind == planEntry::PLAN_C2C_FORWARD) ? FFTW_FORWARD : FFTW_BACKWARD,
+										   flags);
+	}
+	else if(mode == FFTA_PLAN_BATCHED) {
+		/*
+		 * fftaFftwTraits<T>::plan_with_nthreads() is global planner state, it is only changed
+		 * here (under sm_planMutex) and restored to 1 for other plans
+		 */
+		if(!sm_threadsInitialized) {
+			if(fftaFftwTraits<T>::init_threads() == 0) {
+				return nullptr;
+			}
+
+			sm_threadsInitialized = true;
+		}
+
+		fftaFftwTraits<T>::plan_with_nthreads(threads);
+
+		p = fftaFftwTraits<T>::plan_many_dft_r2c(1, &n, how_many,
+									this->m_inputBuffer, nullptr, 1, in_distance,
+									out, nullptr, 1, out_distance, flags);
+
+		fftaFftwTraits<T>::plan_with_nthreads(1);
+	}
+	else {
+		p = fftaFftwTraits<T>::plan_dft_r2c_1d(n, this->m_inputBuffer, out, flags);
+	}
+
+	if(p == NULL) {
+		return nullptr;
+	}
+
+	entry = new planEntry();
+	entry->pdm_kind = kind;
+	entry->pdm_planMode = mode;
+	entry->pdm_size = n;
+	entry->pdm_howMany = how_many;
+	entry->pdm_inputDistance = in_distance;
+	entry->pdm_outputDistance = out_distance;
+	entry->pdm_threads = threads;
+	entry->pdm_flags = flags;
+	entry->pdm_refCount = 1;
+	entry->pdm_plan = p;
+
+	sm_planCache.push_back(entry);
+	return entry;
+}
+
+
+/*
+ * Releases this object's shared plans, destroying each one when no other
+ * instance uses it.  Called with sm_planMutex held.
+ */
+template<typename T>
+void
+FFTAudioT<T>::_destroy_plans()
+{
+	this->_release_plan(m_plan);
+	this->_release_plan(m_inversePlan);
+	this->_release_plan(m_zoomForwardPlan);
+	this->_release_plan(m_zoomBackwardPlan);
+}
+
+
+template<typename T>
+void
+FFTAudioT<T>::_release_plan(planEntry *&entry)
+{
+	if(entry == nullptr) {
+		return;
+	}
+
+	if(--entry->pdm_refCount == 0) {
+		for(size_t i = 0; i < sm_planCache.size(); ++i) {
+			if(sm_planCache[i] == entry) {
+				sm_planCache.erase(sm_planCache.begin() + i);
+				break;
+			}
+		}
+
+		fftaFftwTraits<T>::destroy_plan(entry->pdm_plan);
+		delete entry;
+	}
+
+	entry = nullptr;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_is_simd_aligned()
+ ***************************************************************/
+
+/*
+ * Returns true if the input and output slice of every batch has fftw's simd
+ * alignment, which slices of a packed layout may not
+ */
+template<typename T>
+bool
+FFTAudioT<T>::_is_simd_aligned() const
+{
+	fftwComplex		*out = (m_transformBuffer != nullptr) ? m_transformBuffer : m_outputBuffer;
+
+	if(this->_uses_zoom()) {
+		for(int i = 0; i < m_workerCount; ++i) {
+			if(fftaFftwTraits<T>::alignment_of((T *)&m_zoomWorkBuffer[(size_t)m_zoomStride * i]) != 0) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	return this->_is_simd_aligned(this->m_inputBuffer, out);
+}
+
+
+/*
+ * Returns true if every batch slice of 'input' and of the fft output 'output'
+ * has fftw's simd alignment, null buffers aren't checked
+ */
+template<typename T>
+bool
+FFTAudioT<T>::_is_simd_aligned(const T *input, const fftwComplex *output) const
+{
+	for(int i = 0; i < this->getBatchCount(); ++i) {
+		if(input != nullptr && fftaFftwTraits<T>::alignment_of((T *)&input[(size_t)m_inputStride * i]) != 0) {
+			return false;
+		}
+
+		if(output != nullptr && fftaFftwTraits<T>::alignment_of((T *)&output[(size_t)m_transformStride * i]) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioT::run()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioT<T>::_run(int thread_index)
+{
+	uint64_t	generation = 0;
+	uint64_t	idle_start = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	::pthread_mutex_lock(&m_mutex);
+
+	do {
+		while(m_workGeneration == generation && !m_shutdown) {
+			::pthread_cond_wait(&m_workCond, &m_mutex);
+		}
+
+		if(m_shutdown) {
+			break;
+		}
+
+		generation = m_workGeneration;
+		::pthread_mutex_unlock(&m_mutex);
+
+		this->_run_timed_job(thread_index, idle_start);
+
+		::pthread_mutex_lock(&m_mutex);
+
+		if(--m_activeWorkers == 0) {
+			::pthread_cond_signal(&m_ctrlCond);
+		}
+	} while(true);
+
+	::pthread_mutex_unlock(&m_mutex);
+}
+
+
+/***************************************************************
+ * FFTAudioT::_run_low_latency()
+ ***************************************************************/
+
+/*
+ * Worker loop for FFTA_DISPATCH_LOW_LATENCY
+ */
+template<typename T>
+void
+FFTAudioT<T>::_run_low_latency(int thread_index)
+{
+	int			sense = 0;
+	uint64_t	idle_start;
+
+	::pthread_mutex_lock(&m_mutex);
+
+	while(!m_threadsStarted) {
+		::pthread_cond_wait(&m_workCond, &m_mutex);
+	}
+
+	::pthread_mutex_unlock(&m_mutex);
+
+	idle_start = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	do {
+		m_barrier.wait(sense);
+
+		if(m_shutdown) {
+			break;
+		}
+
+		this->_run_timed_job(thread_index, idle_start);
+
+		m_barrier.wait(sense);
+	} while(true);
+}
+
+
+/*
+ * Runs the current job on a worker, recording its busy time and the idle time
+ * since 'idle_start', which is advanced to the end of the job
+ */
+template<typename T>
+void
+FFTAudioT<T>::_run_timed_job(int thread_index, uint64_t &idle_start)
+{
+	uint64_t	busy_start;
+	uint64_t	busy_end;
+	int			items;
+
+	if(!this->_stats_enabled()) {
+		this->_run_job(thread_index);
+		return;
+	}
+
+	busy_start = this->_stats_clock();
+	items = this->_run_job(thread_index);
+	busy_end = this->_stats_clock();
+
+	this->_stats_add_worker(thread_index, busy_end - busy_start, busy_start - idle_start, items);
+	idle_start = busy_end;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_run_coordinator()
+ ***************************************************************/
+
+/*
+ * Coordinator loop, runs queued batches in order and delivers completions.
+ * Exits once shut down and every queued batch has completed.
+ */
+template<typename T>
+void
+FFTAudioT<T>::_run_coordinator()
+{
+	int64_t		ticket;
+	bufferSet	*buffer_set;
+
+	::pthread_mutex_lock(&m_asyncMutex);
+
+	do {
+		while(m_completedTickets == m_nextTicket && !m_coordinatorShutdown) {
+			::pthread_cond_wait(&m_asyncCond, &m_asyncMutex);
+		}
+
+		if(m_completedTickets == m_nextTicket) {
+			break;
+		}
+
+		ticket = m_completedTickets;
+		buffer_set = &m_bufferSets[ticket % m_bufferSets.size()];
+		::pthread_mutex_unlock(&m_asyncMutex);
+
+		this->_run_batch(*buffer_set, buffer_set->bsm_input);
+
+		::pthread_mutex_lock(&m_asyncMutex);
+		m_readyTickets = ticket + 1;
+		::pthread_mutex_unlock(&m_asyncMutex);
+
+		/*
+		 * The buffer set can't be reused until the callback returns
+		 */
+		this->_notify_complete(ticket);
+
+		::pthread_mutex_lock(&m_asyncMutex);
+		m_completedTickets = ticket + 1;
+		::pthread_cond_broadcast(&m_asyncCond);
+	} while(true);
+
+	::pthread_mutex_unlock(&m_asyncMutex);
+}
+
+
+/*
+ * Stops the coordinator thread after the queued batches complete
+ */
+template<typename T>
+void
+FFTAudioT<T>::_stop_coordinator()
+{
+	if(!m_coordinatorStarted) {
+		return;
+	}
+
+	::pthread_mutex_lock(&m_asyncMutex);
+	m_coordinatorShutdown = true;
+	::pthread_cond_broadcast(&m_asyncCond);
+	::pthread_mutex_unlock(&m_asyncMutex);
+
+	::pthread_join(m_coordinatorTid, NULL);
+	m_coordinatorStarted = false;
+}
+
+
+/*
+ * Static coordinator thread main() function
+ */
+template<typename T>
+void *
+FFTAudioT<T>::_ffta_coordinator_main(void *arg)
+{
+	((FFTAudioT *)arg)->_run_coordinator();
+	return nullptr;
+}
+
+
+/*
+ * Static work thread main() function
+ */
+template<typename T>
+void *
+FFTAudioT<T>::_ffta_fftw_main(void *arg)
+{	
+	threadArgument	*thr_data = (threadArgument *)arg;
+	FFTAudioT		*ffta = thr_data->tdm_ffta;
+	int				thr_idx = thr_data->tdm_threadIndex;
+
+	delete thr_data;
+
+	if(ffta->m_dispatchMode == FFTA_DISPATCH_LOW_LATENCY) {
+		ffta->_run_low_latency(thr_idx);
+	}
+	else {
+		ffta->_run(thr_idx);
+	}
+
+	return nullptr;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_init_threads()
+ ***************************************************************/
+
+/*
+ * Called by initialization function to perform thread creation
+ */
+template<typename T>
+fftaStatus
+FFTAudioT<T>::_init_threads()
+{
+	pthread_t		tid;
+	pthread_attr_t	attr;
+	threadArgument	*thr_arg;
+	const cpu_set_t	*cpus;
+	fftaStatus		ret = FFTA_SUCCESS;
+	int				err;
+
+	::pthread_mutex_lock(&m_mutex);
+
+	for(int i = 0; i < m_workerCount; ++i) {
+		thr_arg = new threadArgument(this, i);
+
+		/*
+		 * Bound workers start on their cpus, so their first touches are local
+		 */
+		cpus = ((size_t)i < m_workerCpus.size() && CPU_COUNT(&m_workerCpus[i]) > 0) ? &m_workerCpus[i] : &m_allWorkerCpus;
+
+		this->_init_thread_attr(attr, cpus);
+		err = ::pthread_create(&tid, &attr, _ffta_fftw_main, thr_arg);
+		::pthread_attr_destroy(&attr);
+
+		if(err != 0) {
+			delete thr_arg;
+
+			/*
+			 * Without the needed privilege (CAP_SYS_NICE or RLIMIT_RTPRIO),
+			 * SCHED_FIFO threads can't be created
+			 */
+			if(err == EPERM && m_realtimePriority > 0) {
+				ret = fftaStatus(FFTA_REALTIME_SETUP_FAILED, err);
+			}
+			else {
+				ret = FFTA_THREAD_CREATE_FAILED;
+			}
+			break;
+		}
+
+		m_tids.push_back(tid);
+	}
+
+	/*
+	 * Low-latency workers wait until the barrier is sized to the threads that
+	 * were actually created (plus the thread calling execute())
+	 */
+	m_barrier.initialize((int)m_tids.size() + 1, m_spinCount);
+	m_threadsStarted = true;
+	::pthread_cond_broadcast(&m_workCond);
+	::pthread_mutex_unlock(&m_mutex);
+
+	return ret;
+}
+
+
+/*
+ * Initializes 'attr' for a worker or coordinator thread, with the cpu binding
+ * 'cpus' (if not empty) and the real-time priority
+ */
+template<typename T>
+void
+FFTAudioT<T>::_init_thread_attr(pthread_attr_t &attr, const cpu_set_t *cpus) const
+{
+	struct sched_param	param;
+
+	::pthread_attr_init(&attr);
+
+	/*
+	 * mlockall() locks the whole stack mapping of every thread
+	 */
+	if(m_realtime && m_lockMemory) {
+		::pthread_attr_setstacksize(&attr, REALTIME_STACK_SIZE);
+	}
+
+	if(cpus != nullptr && CPU_COUNT(cpus) > 0) {
+		::pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), cpus);
+	}
+
+	if(m_realtimePriority > 0) {
+		param.sched_priority = m_realtimePriority;
+
+		::pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		::pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		::pthread_attr_setschedparam(&attr, &param);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioT::_start_coordinator()
+ ***************************************************************/
+
+/*
+ * Starts the executeAsync() coordinator thread
+ *
+ *	  Returns 0 or the pthread_create() error
+ */
+template<typename T>
+int
+FFTAudioT<T>::_start_coordinator()
+{
+	pthread_attr_t	attr;
+	int				err;
+
+	this->_init_thread_attr(attr, nullptr);
+	err = ::pthread_create(&m_coordinatorTid, &attr, _ffta_coordinator_main, this);
+	::pthread_attr_destroy(&attr);
+
+	if(err == 0) {
+		m_coordinatorStarted = true;
+	}
+
+	return err;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_allocate_buffers()
+ ***************************************************************/
+
+/*
+ * Carves every buffer from the arena: the input, output and output stage
+ * buffers of each buffer set, the shared fft output when target frequencies
+ * are gathered from it, the per-worker average accumulators and zoom work
+ * buffers and the zoom filter, plus those of a derived engine.  Each buffer
+ * starts on a cache line (or the slice alignment), batch slices are padded by
+ * the strides.
+ */
+template<typename T>
+fftaStatus
+FFTAudioT<T>::_allocate_buffers()
+{
+	const size_t		batches = (size_t)this->getBatchCount();
+	const size_t		workers = (size_t)m_workerCount;
+	size_t				align = FFTAudioBaseT<T>::AVERAGE_ALIGNMENT;
+	std::vector<size_t>	input_at(m_asyncBufferCount);
+	std::vector<size_t>	output_at(m_asyncBufferCount);
+	std::vector<size_t>	post_at(m_asyncBufferCount);
+	size_t				transform_at = 0;
+	size_t				average_at = 0;
+	size_t				zoom_at = 0;
+	size_t				filter_at = 0;
+	size_t				post_sz = batches * this->_get_post_process_stride() * sizeof(T);
+	int					err;
+
+	if((size_t)this->_get_slice_alignment() > align) {
+		align = (size_t)this->_get_slice_alignment();
+	}
+
+	m_inputStride = this->_align_slice(this->getPaddedFrameSize(), sizeof(T));
+	m_transformStride = this->_align_slice(this->_get_transform_bin_count() + 1, sizeof(fftwComplex));
+	m_zoomStride = this->_align_slice(this->_get_zoom_length(), sizeof(fftwComplex));
+
+	/*
+	 * Plans are created on the first buffer set
+	 */
+	for(int i = 0; i < m_asyncBufferCount; ++i) {
+		input_at[i] = m_arena.reserve(batches * m_inputStride * sizeof(T), align);
+		output_at[i] = m_arena.reserve(batches * this->_get_output_stride() * sizeof(fftwComplex), align);
+
+		if(post_sz > 0) {
+			post_at[i] = m_arena.reserve(post_sz, align);
+		}
+	}
+
+	/*
+	 * Target frequencies taken from the fft need the full fft output, it is
+	 * only used while a batch runs so all buffer sets share it
+	 */
+	if(this->_has_target_frequencies() && !this->usesGoertzel()) {
+		transform_at = m_arena.reserve(batches * m_transformStride * sizeof(fftwComplex), align);
+	}
+
+	/*
+	 * One average accumulator per worker
+	 */
+	if(this->_is_averaging()) {
+		average_at = m_arena.reserve(workers * this->_get_average_stride() * sizeof(T), align);
+	}
+
+	/*
+	 * Zoom needs a chirp-z work buffer per worker and the transformed filter
+	 */
+	if(this->_uses_zoom()) {
+		zoom_at = m_arena.reserve(workers * m_zoomStride * sizeof(fftwComplex), align);
+		filter_at = m_arena.reserve((size_t)this->_get_zoom_length() * sizeof(fftwComplex), align);
+	}
+
+	this->_reserve_buffers(m_arena, align, m_workerCount);
+
+	if((err = m_arena.allocate(m_hugePages)) != 0) {
+		return fftaStatus(FFTA_ALLOC_FAILED, err);
+	}
+
+	m_bufferSets.resize(m_asyncBufferCount);
+
+	for(int i = 0; i < m_asyncBufferCount; ++i) {
+		m_bufferSets[i].bsm_inputBuffer = (T *)m_arena.at(input_at[i]);
+		m_bufferSets[i].bsm_outputBuffer = (fftwComplex *)m_arena.at(output_at[i]);
+
+		if(post_sz > 0) {
+			m_bufferSets[i].bsm_postProcessBuffer = (T *)m_arena.at(post_at[i]);
+		}
+	}
+
+	if(this->_has_target_frequencies() && !this->usesGoertzel()) {
+		m_transformBuffer = (fftwComplex *)m_arena.at(transform_at);
+	}
+
+	if(this->_is_averaging()) {
+		m_averageAccumulators = (T *)m_arena.at(average_at);
+	}
+
+	if(this->_uses_zoom()) {
+		m_zoomWorkBuffer = (fftwComplex *)m_arena.at(zoom_at);
+		m_zoomFilter = (fftwComplex *)m_arena.at(filter_at);
+	}
+
+	this->_assign_buffers(m_arena);
+	return FFTA_SUCCESS;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_lock_memory()
+ ***************************************************************/
+
+/*
+ * Locks every page of the process, current and future, into memory: besides
+ * the buffers and tables this covers the fftw plans (twiddles and codelets),
+ * the statistics counters, the thread stacks and the code.  Per-region
+ * mlock() can't do this safely, locks don't nest and tables such as the
+ * shared windows and plans are used by other instances.  mlockall() is
+ * instead reference counted across the real-time instances.
+ *
+ *	  Returns 0 or the mlockall() errno, typically ENOMEM or EPERM when
+ *			RLIMIT_MEMLOCK is too low
+ */
+template<typename T>
+int
+FFTAudioT<T>::_lock_memory()
+{
+	int		err = 0;
+
+	::pthread_mutex_lock(&s_memoryLockMutex);
+
+	if(s_memoryLockCount == 0) {
+		s_memoryLockRelease = (_locked_memory_kb() == 0);
+
+		if(::mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+			err = errno;
+		}
+	}
+
+	if(err == 0) {
+		++s_memoryLockCount;
+		m_memoryLocked = true;
+	}
+
+	::pthread_mutex_unlock(&s_memoryLockMutex);
+	return err;
+}
+
+
+/***************************************************************
+ * FFTAudioT::_unlock_memory()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioT<T>::_unlock_memory()
+{
+	::pthread_mutex_lock(&s_memoryLockMutex);
+
+	if(--s_memoryLockCount == 0 && s_memoryLockRelease) {
+		::munlockall();
+	}
+
+	::pthread_mutex_unlock(&s_memoryLockMutex);
+	m_memoryLocked = false;
+}
+
+
+/***************************************************************
+ * Explicit instantiations
+ ***************************************************************/
+
+template class FFTAudioT<float>;
+template class FFTAudioT<double>;
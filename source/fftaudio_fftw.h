@@ -19,22 +19,210 @@
 #define FFTA__FFTW__H__
 
 
+#include	<atomic>
+#include	<cstdint>
 #include	<cstdlib>
 #include	<vector>
 #include	<pthread.h>
+#include	<sched.h>
 #include	<fftw3.h>
 
 #include	"fftaudio_base.h"
+#include	"fftaudio_barrier.h"
+#include	"fftaudio_arena.h"
+
+
+//
+// Worker dispatch modes, for use with setDispatchMode()
+//
+typedef enum ffta_dispatch_mode_enum {
+	// Workers sleep on a condition variable between calls to execute()
+	FFTA_DISPATCH_CONDVAR = 0,
+
+	// Workers and the calling thread synchronize through an atomic barrier,
+	// spinning briefly before sleeping.  Lowest latency for small frames at
+	// the cost of some cpu time spent spinning after each call.
+	FFTA_DISPATCH_LOW_LATENCY
+} fftaDispatchMode;
+
+
+//
+// Plan modes, for use with setPlanMode()
+//
+typedef enum ffta_plan_mode_enum {
+	// Each worker thread converts the batches it claims and transforms them
+	// with a single-transform plan
+	FFTA_PLAN_PER_BATCH = 0,
+
+	// A single advanced-interface plan covers all batches and runs on fftw's
+	// own threads, the worker threads only convert the input samples
+	FFTA_PLAN_BATCHED
+} fftaPlanMode;
+
+
+//
+// Planner effort, for use with setPlannerEffort().  Higher effort takes longer
+// to plan and may produce faster plans, use loadWisdom()/saveWisdom() to keep
+// planning results across runs.
+//
+typedef enum ffta_planner_effort_enum {
+	// FFTW_ESTIMATE, no measurement, instant
+	FFTA_PLANNER_ESTIMATE = 0,
+
+	// FFTW_MEASURE (default)
+	FFTA_PLANNER_MEASURE,
+
+	// FFTW_PATIENT
+	FFTA_PLANNER_PATIENT,
+
+	// FFTW_EXHAUSTIVE
+	FFTA_PLANNER_EXHAUSTIVE,
+
+	// FFTW_WISDOM_ONLY, plan only from loaded wisdom.  Falls back to
+	// FFTW_ESTIMATE when no wisdom exists for the configuration.
+	FFTA_PLANNER_WISDOM_ONLY
+} fftaPlannerEffort;
+
+
+//
+// fftw api for each floating point type, selects the fftwf_ (float) or fftw_
+// (double) functions at compile time
+//
+template<typename T>
+class fftaFftwTraits;
+
+template<>
+class fftaFftwTraits<float>
+{
+public:
+	typedef fftwf_plan		plan;
+	typedef fftwf_complex	complex;
+
+	static void *malloc(size_t n)									{ return ::fftwf_malloc(n);							}
+	static void free(void *p)										{ ::fftwf_free(p);									}
+	static int alignment_of(float *p)								{ return ::fftwf_alignment_of(p);					}
+	static void destroy_plan(plan p)								{ ::fftwf_destroy_plan(p);							}
+	static int init_threads()										{ return ::fftwf_init_threads();					}
+	static void plan_with_nthreads(int n)							{ ::fftwf_plan_with_nthreads(n);					}
+	static int import_wisdom(const char *f)							{ return ::fftwf_import_wisdom_from_filename(f);	}
+	static int export_wisdom(const char *f)							{ return ::fftwf_export_wisdom_to_filename(f);		}
+	static const char *wisdom_variable()							{ return "FFTA_WISDOM_FILE";						}
+
+	static plan plan_dft_r2c_1d(int n, float *in, complex *out, unsigned flags)
+	{
+		return ::fftwf_plan_dft_r2c_1d(n, in, out, flags);
+	}
+
+	static plan plan_many_dft_r2c(int rank, const int *n, int how_many,
+								  float *in, const int *inembed, int istride, int idist,
+								  complex *out, const int *onembed, int ostride, int odist, unsigned flags)
+	{
+		return ::fftwf_plan_many_dft_r2c(rank, n, how_many, in, inembed, istride, idist,
+										 out, onembed, ostride, odist, flags);
+	}
+
+	static void execute_dft_r2c(const plan p, float *in, complex *out)
+	{
+		::fftwf_execute_dft_r2c(p, in, out);
+	}
+
+	static plan plan_dft_c2r_1d(int n, complex *in, float *out, unsigned flags)
+	{
+		return ::fftwf_plan_dft_c2r_1d(n, in, out, flags);
+	}
+
+	static void execute_dft_c2r(const plan p, complex *in, float *out)
+	{
+		::fftwf_execute_dft_c2r(p, in, out);
+	}
+
+	static plan plan_dft_1d(int n, complex *in, complex *out, int sign, unsigned flags)
+	{
+		return ::fftwf_plan_dft_1d(n, in, out, sign, flags);
+	}
+
+	static void execute_dft(const plan p, complex *in, complex *out)
+	{
+		::fftwf_execute_dft(p, in, out);
+	}
+};
+
+template<>
+class fftaFftwTraits<double>
+{
+public:
+	typedef fftw_plan		plan;
+	typedef fftw_complex	complex;
+
+	static void *malloc(size_t n)									{ return ::fftw_malloc(n);							}
+	static void free(void *p)										{ ::fftw_free(p);									}
+	static int alignment_of(double *p)								{ return ::fftw_alignment_of(p);					}
+	static void destroy_plan(plan p)								{ ::fftw_destroy_plan(p);							}
+	static int init_threads()										{ return ::fftw_init_threads();						}
+	static void plan_with_nthreads(int n)							{ ::fftw_plan_with_nthreads(n);						}
+	static int import_wisdom(const char *f)							{ return ::fftw_import_wisdom_from_filename(f);		}
+	static int export_wisdom(const char *f)							{ return ::fftw_export_wisdom_to_filename(f);		}
+	static const char *wisdom_variable()							{ return "FFTA_WISDOM_FILE_DOUBLE";					}
+
+	static plan plan_dft_r2c_1d(int n, double *in, complex *out, unsigned flags)
+	{
+		return ::fftw_plan_dft_r2c_1d(n, in, out, flags);
+	}
+
+	static plan plan_many_dft_r2c(int rank, const int *n, int how_many,
+								  double *in, const int *inembed, int istride, int idist,
+								  complex *out, const int *onembed, int ostride, int odist, unsigned flags)
+	{
+		return ::fftw_plan_many_dft_r2c(rank, n, how_many, in, inembed, istride, idist,
+										out, onembed, ostride, odist, flags);
+	}
+
+	static void execute_dft_r2c(const plan p, double *in, complex *out)
+	{
+		::fftw_execute_dft_r2c(p, in, out);
+	}
+
+	static plan plan_dft_c2r_1d(int n, complex *in, double *out, unsigned flags)
+	{
+		return ::fftw_plan_dft_c2r_1d(n, in, out, flags);
+	}
+
+	static void execute_dft_c2r(const plan p, complex *in, double *out)
+	{
+		::fftw_execute_dft_c2r(p, in, out);
+	}
+
+	static plan plan_dft_1d(int n, complex *in, complex *out, int sign, unsigned flags)
+	{
+		return ::fftw_plan_dft_1d(n, in, out, sign, flags);
+	}
+
+	static void execute_dft(const plan p, complex *in, complex *out)
+	{
+		::fftw_execute_dft(p, in, out);
+	}
+};
 
 
 //
 // FFTAudio implementation for fftw api
+//		'T' selects single (float, fftwf_) or double (double, fftw_) precision,
+//		use the FFTAudio and FFTAudioDouble typedefs
 //
-class FFTAudio : public FFTAudioBase
+template<typename T>
+class FFTAudioT : public FFTAudioBaseT<T>
 {
+public:
+	typedef typename FFTAudioBaseT<T>::FuncInitWindowCB		FuncInitWindowCB;
+
+protected:
+	typedef typename FFTAudioBaseT<T>::inputDescriptor		inputDescriptor;
+	typedef typename fftaFftwTraits<T>::complex				fftwComplex;
+	typedef typename fftaFftwTraits<T>::plan				fftwPlan;
+
 public:
 	/*
-	 * FFTAudio class constructor
+	 * FFTAudioT class constructor
 	 *		window_type - fft window type/function, from fftaudio_windows.h
 	 *		sample_rate - sample rate, in hz
 	 *		frame_size - frame size, in samples
@@ -42,10 +230,10 @@ public:
 	 *			Can be 0, in which case padded frame size == frame_size
 	 *		batch_count - Number of fft's to perform
 	 */
-	FFTAudio(FuncInitWindowCB window_type, int sample_rate,
-			 int frame_size, int padded_frame_size, int batch_count = 1);
+	FFTAudioT(FuncInitWindowCB window_type, int sample_rate,
+			  int frame_size, int padded_frame_size, int batch_count = 1);
 
-	virtual ~FFTAudio();
+	virtual ~FFTAudioT();
 
 	/*
 	 * initialize()
@@ -58,31 +246,369 @@ public:
 	virtual fftaStatus initialize();
 
 	/*
-	 * execute()
+	 * setWorkerCount()
+	 *
+	 * Sets the number of worker threads used to process batches.  Must be called
+	 * before initialize().  Batches are distributed dynamically across the
+	 * workers, so the worker count is independent of 'batch_count'.  No more
+	 * workers are started than the largest job has items: 'batch_count', or
+	 * more for engines with other jobs (e.g. the pairs of FFTAudioGccPhatT).
 	 *
-	 * Executes a batch of fft's
+	 * worker_count - number of worker threads, 0 selects the number of online
+	 *			processors (default)
+	 *
+	 *	  Returns false if already initialized or 'worker_count' is negative
+	 */
+	bool setWorkerCount(int worker_count);
+
+	/*
+	 * getWorkerCount()
 	 *
-	 * data - Pointer to sample data (signed 16-bit), number of samples must equal
-	 *			'frame_size' * 'batch_count'.
-	 * data_ptrs - 'batch_count' array of pointers to sample data (signed 16-bit),
-	 *			each pointer must point to an array of 'frame_size' samples.
+	 * Returns the number of worker threads, valid after initialize()
 	 */
-	virtual bool execute(const short *data);
-	virtual bool execute(const short * const *data_ptrs);
+	int getWorkerCount() const						{ return (int)m_tids.size();			}
+
+	/*
+	 * setWorkerAffinity() / setWorkerNode()
+	 *
+	 * Binds worker threads to a set of cpus, or to the cpus of a NUMA node.
+	 * Must be called before initialize().  Once any worker is bound, batches
+	 * are divided statically, worker 'w' of 'W' always processing batches
+	 * 'batch_count' * w / W --> 'batch_count' * (w + 1) / W - 1.  Each worker
+	 * clears its slices of the buffers during initialize(), so with the
+	 * kernel's default local allocation their pages live on its node, unless
+	 * huge pages are used (see setHugePages()).  fftw's own threads
+	 * (FFTA_PLAN_BATCHED with 'plan_threads' > 1) aren't bound.
+	 *
+	 * worker_index - worker to bind, -1 binds every worker not bound
+	 *			individually
+	 * cpus - cpus the worker may run on
+	 * node - NUMA node, as numbered in /sys/devices/system/node
+	 *
+	 *	  Returns false if already initialized, 'worker_index' is less than -1,
+	 *			'cpus' is empty or the node's cpus can't be read
+	 */
+	bool setWorkerAffinity(int worker_index, const cpu_set_t &cpus);
+	bool setWorkerNode(int worker_index, int node);
+
+	/*
+	 * setRealtime()
+	 *
+	 * Prepares for real-time use.  Must be called before initialize(), which
+	 * then locks all memory of the process with mlockall(MCL_CURRENT |
+	 * MCL_FUTURE), starts the executeAsync() coordinator up front and, with a
+	 * 'priority', creates the worker and coordinator threads with SCHED_FIFO.
+	 * The lock is shared by all real-time instances and released with the
+	 * last one, unless the process had already locked memory before the
+	 * first one.  Worker and coordinator threads then use
+	 * REALTIME_STACK_SIZE stacks, which are locked in full.  execute() doesn't
+	 * allocate memory after initialize() in any mode, build the library with
+	 * FFTA_RT_ALLOC_CHECK to verify (see fftaAllocCheck).  initialize() fails
+	 * with FFTA_REALTIME_SETUP_FAILED if memory can't be locked
+	 * (RLIMIT_MEMLOCK) or SCHED_FIFO isn't permitted.
+	 *
+	 * priority - SCHED_FIFO priority of the threads, 0 keeps the default
+	 *			scheduling
+	 * lock_memory - lock the process memory with mlockall()
+	 *
+	 *	  Returns false if already initialized or 'priority' is outside the
+	 *			SCHED_FIFO range
+	 */
+	bool setRealtime(int priority, bool lock_memory = true);
+
+	/*
+	 * setSliceAlignment()
+	 *
+	 * Pads each batch's slice of the input, output, output stage and work
+	 * buffers to a multiple of 'bytes', so workers writing neighbouring batches
+	 * never share a cache line (64) or, for NUMA placement with
+	 * setWorkerNode(), a page (4096).  Must be called before initialize().
+	 * Results are read the same way, the padding only costs memory.
+	 *
+	 * bytes - slice alignment, 0 packs the slices (default), otherwise a power
+	 *			of two of at least 64
+	 *
+	 *	  Returns false if already initialized or 'bytes' is invalid
+	 */
+	bool setSliceAlignment(int bytes);
+
+	/*
+	 * setHugePages() / getHugePages()
+	 *
+	 * Selects the page size of the buffer arena.  initialize() carves every
+	 * buffer execute() writes (the input, output and output stage buffers of
+	 * each buffer set, work buffers and accumulators) from one region, which
+	 * with huge pages needs far fewer TLB entries for large batches.  Must be
+	 * called before initialize().  With FFTA_HUGE_PAGES_EXPLICIT, the reserved
+	 * pool must hold the whole region, rounded up to the huge page size.
+	 *
+	 * Huge pages defeat the per-worker first-touch placement of
+	 * setWorkerNode(): each huge page (typically 2 MB) is placed as a whole on
+	 * the node of the worker that touches it first, so every slice within it,
+	 * whichever worker processes it, lands on that node.  Keep the default
+	 * FFTA_HUGE_PAGES_NONE when workers span NUMA nodes, unless each worker's
+	 * slices cover whole huge pages.
+	 *
+	 * mode - 'fftaHugePageMode' value, default is FFTA_HUGE_PAGES_NONE
+	 *
+	 *	  setHugePages() returns false if already initialized
+	 *	  getHugePages() returns the mode in effect after initialize(), which is
+	 *			FFTA_HUGE_PAGES_TRANSPARENT when explicit huge pages weren't
+	 *			available and FFTA_HUGE_PAGES_NONE when the kernel doesn't
+	 *			support transparent huge pages
+	 */
+	bool setHugePages(fftaHugePageMode mode);
+	fftaHugePageMode getHugePages() const			{ return m_arena.getHugePageMode();		}
+
+	/*
+	 * setDispatchMode()
+	 *
+	 * Selects how execute() hands work to the worker threads and waits for
+	 * them.  Must be called before initialize().
+	 *
+	 * mode - 'fftaDispatchMode' value, default is FFTA_DISPATCH_CONDVAR
+	 * spin_count - FFTA_DISPATCH_LOW_LATENCY only, number of polling iterations
+	 *			a waiting thread spins before sleeping
+	 *
+	 *	  Returns false if already initialized
+	 */
+	bool setDispatchMode(fftaDispatchMode mode, int spin_count = DEFAULT_SPIN_COUNT);
+
+	/*
+	 * setPlanMode()
+	 *
+	 * Selects how fftw plans are created and executed.  Must be called before
+	 * initialize().
+	 *
+	 * mode - 'fftaPlanMode' value, default is FFTA_PLAN_PER_BATCH
+	 * plan_threads - FFTA_PLAN_BATCHED only, number of threads fftw uses to
+	 *			execute the batched plan, 0 uses the worker count
+	 *
+	 *	  Returns false if already initialized or 'plan_threads' is negative
+	 */
+	bool setPlanMode(fftaPlanMode mode, int plan_threads = 0);
+
+	/*
+	 * setPlannerEffort()
+	 *
+	 * Selects the fftw planner effort.  Must be called before initialize().  If
+	 * not called, the FFTA_PLANNER_EFFORT environment variable is used
+	 * ("estimate", "measure", "patient", "exhaustive" or "wisdom_only"), and
+	 * otherwise FFTA_PLANNER_MEASURE.
+	 *
+	 * effort - 'fftaPlannerEffort' value
+	 *
+	 *	  Returns false if already initialized
+	 */
+	bool setPlannerEffort(fftaPlannerEffort effort);
+
+	/*
+	 * setAsyncBufferCount()
+	 *
+	 * Sets the number of input/output buffer sets executeAsync() rotates
+	 * through.  Must be called before initialize().  With 2 or more, a batch
+	 * can be transformed while the results of the previous one are read.
+	 *
+	 * buffer_count - number of buffer sets, default is 1
+	 *
+	 *	  Returns false if already initialized or 'buffer_count' is less than 1
+	 */
+	bool setAsyncBufferCount(int buffer_count);
+
+	/*
+	 * bindBuffers()
+	 *
+	 * Makes batches submitted by later execute() / executeAsync() calls use
+	 * caller-owned buffers instead of the engine's, so each spectrum stays in
+	 * the caller's memory (e.g. a ring buffer) after the next call.  Must be
+	 * called after initialize().  The windowed frames are written to 'input'
+	 * and the plans execute from it into 'complex_out', where results are read
+	 * by getBinValue(), getComplexSpectrum() etc. once the batch completes.
+	 * Output stages, averages and target gathering keep using engine buffers.
+	 * The buffers must stay valid until those batches complete, real-time mode
+	 * doesn't lock them.  The plans are out-of-place, so the two buffers must
+	 * not overlap: an in-place layout isn't supported.
+	 *
+	 * input - getBatchCount() * getInputStride() values, batch 'n' frame at
+	 *			&input[n * getInputStride()], null uses the engine's buffer
+	 * complex_out - getBatchCount() * getOutputStride() interleaved (real,
+	 *			imaginary) pairs, batch 'n' spectrum at
+	 *			&complex_out[2 * n * getOutputStride()], null uses the engine's
+	 *			buffer
+	 *
+	 *	  Returns false if not initialized, if 'input' and 'complex_out'
+	 *			overlap, or if the plans need simd aligned slices (see
+	 *			getInputStride()) and a buffer isn't
+	 */
+	bool bindBuffers(T *input, T *complex_out);
+
+	/*
+	 * getInputStride()
+	 *
+	 * Returns the distance between the frames of consecutive batches in
+	 * bindBuffers() input buffers, 'padded_frame_size' unless slices are
+	 * padded.  64 byte aligned buffers are always accepted when
+	 * setSliceAlignment() pads the slices, or when the packed strides keep
+	 * every slice simd aligned.  Valid after initialize().
+	 */
+	int getInputStride() const						{ return m_inputStride;					}
+
+	/*
+	 * wait() / selectResult()
+	 *
+	 * See FFTAudioBaseT
+	 */
+	virtual bool wait(int64_t ticket);
+	virtual bool selectResult(int64_t ticket);
+
+	/*
+	 * loadWisdom() / saveWisdom()
+	 *
+	 * Imports/exports process-wide fftw wisdom from/to a file.  fftw keeps
+	 * separate wisdom for each precision, so FFTAudio and FFTAudioDouble each
+	 * load and save their own files.  Wisdom loaded
+	 * before initialize() lets plans of a previously seen configuration be
+	 * created without measuring.  If the FFTA_WISDOM_FILE (FFTAudio) or
+	 * FFTA_WISDOM_FILE_DOUBLE (FFTAudioDouble) environment variable is set,
+	 * that file is loaded automatically by the first initialize() of the
+	 * precision, a failure to import it is reported on stderr.
+	 *
+	 * filename - path of wisdom file
+	 *
+	 *	  Returns false if the file could not be read/written
+	 */
+	static bool loadWisdom(const char *filename);
+	static bool saveWisdom(const char *filename);
+
+	/*
+	 * Default spin iterations for FFTA_DISPATCH_LOW_LATENCY, roughly tens of
+	 * microseconds on current hardware
+	 */
+	static const int DEFAULT_SPIN_COUNT = 20000;
+
+	/*
+	 * Stack size of the worker and coordinator threads in real-time mode with
+	 * locked memory, fftw's codelets keep their stack use well below this
+	 */
+	static const size_t REALTIME_STACK_SIZE = 512 * 1024;
+
+	/*
+	 * Number of bins each item of the parallel average reduction covers
+	 */
+	static const int AVERAGE_REDUCE_CHUNK = 1024;
 
 protected:
 	/*
-	 * Returns real^2 + complex^2 of fftwf_complex type at bin index 'bin_index'
+	 * Executes a batch of fft's on the worker threads
+	 */
+	virtual bool _execute(const inputDescriptor &input);
+
+	/*
+	 * Queues a batch of fft's for the coordinator thread
 	 */
-	virtual inline float _get_complex_result(int bin_index) const
+	virtual int64_t _execute_async(const inputDescriptor &input);
+
+	/*
+	 * Returns real^2 + complex^2 of fftw complex type at bin index 'bin_index'
+	 */
+	virtual inline T _get_complex_result(int bin_index) const
+	{
+		return ((m_resultBuffer[bin_index][0] * m_resultBuffer[bin_index][0])
+						+ (m_resultBuffer[bin_index][1] * m_resultBuffer[bin_index][1]));
+	}
+
+	/*
+	 * Returns the fftw complex output buffer as interleaved 'T' pairs
+	 */
+	virtual const T *_get_complex_buffer() const
+	{
+		return (const T *)m_resultBuffer;
+	}
+
+	/*
+	 * Returns the output stage buffer of the selected buffer set
+	 */
+	virtual const T *_get_post_process_buffer() const
+	{
+		return m_resultPostProcess;
+	}
+
+	/*
+	 * Extension interface for engines built on this backend, such as
+	 * FFTAudioConvolverT.  They run their own jobs on the worker threads with
+	 * _dispatch() and carve their buffers from the same arena.
+	 *
+	 * Work item function type, called by a worker thread for each claimed item
+	 */
+	typedef void (FFTAudioT::*FuncJob)(int worker_index, int item_index);
+
+	void		_dispatch(FuncJob job_func, int item_count);
+
+	/*
+	 * _forward_transform() / _inverse_transform() run the 'padded_frame_size'
+	 * plans between 'padded_frame_size' real values and 'padded_frame_size' / 2
+	 * + 1 interleaved complex values, both aligned like the arena's buffers.
+	 * The forward plan is that of execute(), so FFTA_PLAN_PER_BATCH only.
+	 * The inverse is unscaled and overwrites 'complex_in', its plan is only
+	 * created when _enable_inverse_transform() is called before initialize().
+	 */
+	void _enable_inverse_transform()				{ m_inverseTransform = true;			}
+	void _forward_transform(T *in, T *complex_out) const;
+	void _inverse_transform(T *complex_in, T *out) const;
+
+	/*
+	 * Called by initialize() once the worker count is known, to reserve the
+	 * derived engine's buffers before the arena is allocated, then to resolve
+	 * their addresses
+	 */
+	virtual void _reserve_buffers(fftaArena &, size_t /* alignment */, int /* worker_count */)
+	{
+	}
+
+	virtual void _assign_buffers(const fftaArena &)
 	{
-		return ((m_outputBuffer[bin_index][0] * m_outputBuffer[bin_index][0])
-						+ (m_outputBuffer[bin_index][1] * m_outputBuffer[bin_index][1]));
 	}
 
+	/*
+	 * Returns the item count of the largest job the engine dispatches, which
+	 * caps the worker count
+	 */
+	virtual int _get_max_job_items() const			{ return this->getBatchCount();			}
+
 private:
 	void 		_run(int thread_index);
+	void		_run_coordinator();
+	int			_run_job(int thread_index);
+	void		_run_timed_job(int thread_index, uint64_t &idle_start);
+	void		_run_low_latency(int thread_index);
+	void		_job_convert(int thread_index, int batch_index);
+	void		_job_batch(int thread_index, int batch_index);
+	void		_job_post_process(int thread_index, int batch_index);
+	void		_job_reduce_average(int thread_index, int chunk_index);
+	void		_job_first_touch(int thread_index, int owner_index);
+	void		_get_static_range(int item_count, int thread_index, int &first, int &end) const;
+	fftaStatus	_create_plans(unsigned flags);
+	void		_destroy_plans();
+
+	class planEntry;
+	planEntry	*_acquire_plan(int kind, int n, int how_many, int in_distance, int out_distance,
+							   int threads, unsigned flags);
+	void		_release_plan(planEntry *&entry);
+	bool		_is_simd_aligned() const;
+	bool		_is_simd_aligned(const T *input, const fftwComplex *output) const;
+	bool		_has_post_process_job() const;
+	fftaPlannerEffort	_get_planner_effort() const;
+	unsigned	_get_planner_flags() const;
 	fftaStatus	_init_threads();
+	void		_init_thread_attr(pthread_attr_t &attr, const cpu_set_t *cpus) const;
+	int			_start_coordinator();
+	void		_stop_coordinator();
+	int			_lock_memory();
+	void		_unlock_memory();
+	fftaStatus	_allocate_buffers();
+
+	class bufferSet;
+	void		_run_batch(bufferSet &buffer_set, const inputDescriptor &input);
 
 private:
 	/*
@@ -90,6 +616,11 @@ private:
 	 */
 	static void *_ffta_fftw_main(void *arg);
 
+	/*
+	 * Coordinator thread main function, runs batches queued by executeAsync()
+	 */
+	static void *_ffta_coordinator_main(void *arg);
+
 private:
 	/*
 	 * Object passed to work threads as argument on creation
@@ -97,7 +628,7 @@ private:
 	class threadArgument
 	{
 	public:
-		threadArgument(FFTAudio *ffta_ptr, int thread_idx)
+		threadArgument(FFTAudioT *ffta_ptr, int thread_idx)
 		{
 			tdm_ffta = ffta_ptr;
 			tdm_threadIndex = thread_idx;
@@ -106,25 +637,212 @@ private:
 		virtual ~threadArgument() = default;
 
 	public:
-		FFTAudio				*tdm_ffta;
+		FFTAudioT				*tdm_ffta;
 		int						tdm_threadIndex;
 	};
 
+	/*
+	 * Plans only depend on the transform geometry and planner flags, so
+	 * instances with the same configuration share one reference counted plan
+	 * and execute it against their own buffers
+	 */
+	class planEntry
+	{
+	public:
+		enum {
+			PLAN_R2C = 0,
+			PLAN_C2R,
+			PLAN_C2C_FORWARD,
+			PLAN_C2C_BACKWARD
+		};
+
+	public:
+		int						pdm_kind;
+		fftaPlanMode			pdm_planMode;
+		int						pdm_size;
+		int						pdm_howMany;
+		int						pdm_inputDistance;
+		int						pdm_outputDistance;
+		int						pdm_threads;
+		unsigned				pdm_flags;
+		int						pdm_refCount;
+		fftwPlan				pdm_plan;
+	};
+
+	/*
+	 * Input and output buffers for one batch, 'bsm_input' describes the sample
+	 * data of a batch queued by executeAsync()
+	 */
+	class bufferSet
+	{
+	public:
+		bufferSet() :
+			bsm_input(FFTAudioBaseT<T>::FFTA_SAMPLE_S16, 0, nullptr, nullptr, 1)
+		{
+		}
+
+	public:
+		T						*bsm_inputBuffer = nullptr;
+		fftwComplex				*bsm_outputBuffer = nullptr;
+		T						*bsm_postProcessBuffer = nullptr;
+		inputDescriptor			bsm_input;
+
+		/*
+		 * Caller buffers bound when the batch was submitted, null for the
+		 * buffers above
+		 */
+		T						*bsm_boundInput = nullptr;
+		fftwComplex				*bsm_boundOutput = nullptr;
+	};
+
 	/////////////////////////////////////////////////////////
 
 private:
 	std::vector<pthread_t>		m_tids;
-	std::vector<fftwf_plan>		m_fftwPlans;
-	fftwf_complex				*m_outputBuffer = nullptr;
-	const short * const 		*m_inputDataPointers = nullptr;
-	size_t						m_done = 0;
+
+	/*
+	 * Every buffer is carved from 'm_arena'.  Batch slices of the input buffers
+	 * are 'm_inputStride' values apart, those of the fft output
+	 * (m_transformBuffer) 'm_transformStride' and zoom work buffers
+	 * 'm_zoomStride' complex values apart.
+	 */
+	fftaArena					m_arena;
+	fftaHugePageMode			m_hugePages = FFTA_HUGE_PAGES_NONE;
+	int							m_inputStride = 0;
+	int							m_transformStride = 0;
+	int							m_zoomStride = 0;
+
+	/*
+	 * bindBuffers() buffers for batches submitted next.  'm_unalignedPlans' is
+	 * set when plans were created FFTW_UNALIGNED and accept any buffer.
+	 */
+	T							*m_boundInput = nullptr;
+	fftwComplex					*m_boundOutput = nullptr;
+	bool						m_unalignedPlans = false;
+	planEntry					*m_plan = nullptr;
+	planEntry					*m_zoomForwardPlan = nullptr;
+	planEntry					*m_zoomBackwardPlan = nullptr;
+	planEntry					*m_inversePlan = nullptr;
+	bool						m_inverseTransform = false;
+	fftwComplex					*m_outputBuffer = nullptr;
+
+	/*
+	 * Full fft output when target frequencies are gathered from the fft,
+	 * otherwise null and plans write the output buffer directly
+	 */
+	fftwComplex					*m_transformBuffer = nullptr;
+
+	/*
+	 * Zoom chirp-z work buffers, one per worker 'm_zoomStride' apart, and
+	 * the transformed chirp filter shared by all workers
+	 */
+	fftwComplex					*m_zoomWorkBuffer = nullptr;
+	fftwComplex					*m_zoomFilter = nullptr;
+	fftwComplex					*m_resultBuffer = nullptr;
+	T							*m_resultPostProcess = nullptr;
+	const inputDescriptor		*m_input = nullptr;
+	int							m_workerCount = 0;
+
+	/*
+	 * Worker cpu binding, entries of 'm_workerCpus' with no cpu set (and
+	 * workers beyond it) use 'm_allWorkerCpus', no cpu set means unbound.
+	 * Binding any worker selects the static schedule.
+	 */
+	std::vector<cpu_set_t>		m_workerCpus;
+	cpu_set_t					m_allWorkerCpus;
+	bool						m_staticSchedule = false;
+
+	/*
+	 * Real-time mode, 'm_memoryLocked' once initialize() holds a reference to
+	 * the process-wide memory lock
+	 */
+	bool						m_realtime = false;
+	int							m_realtimePriority = 0;
+	bool						m_lockMemory = false;
+	bool						m_memoryLocked = false;
+	fftaPlanMode				m_planMode = FFTA_PLAN_PER_BATCH;
+	int							m_planThreads = 0;
+	fftaPlannerEffort			m_plannerEffort = FFTA_PLANNER_MEASURE;
+	bool						m_plannerEffortSet = false;
+
+	/*
+	 * Current job, set by _dispatch() and shared by all workers.  Items are
+	 * claimed 'm_jobChunk' at a time from 'm_jobNextItem'.
+	 */
+	FuncJob						m_jobFunc = nullptr;
+	int							m_jobItemCount = 0;
+	int							m_jobChunk = 1;
+	std::atomic<int>			m_jobNextItem;
+
+	/*
+	 * Buffer sets, execute() and queued batches use set 'ticket' % count.  Jobs
+	 * read and write the 'm_work' buffers of the batch being run, results are
+	 * read from the 'm_result' buffers.
+	 */
+	std::vector<bufferSet>		m_bufferSets;
+	int							m_asyncBufferCount = 1;
+	T							*m_workInputBuffer = nullptr;
+	fftwComplex					*m_workOutputBuffer = nullptr;
+	T							*m_workPostProcess = nullptr;
+	bool						m_workInputBound = false;
+
+	/*
+	 * Average accumulators, one per worker thread _get_average_stride() values
+	 * apart, each written only by its worker until the reduction
+	 */
+	T							*m_averageAccumulators = nullptr;
+
+	/*
+	 * executeAsync() state, protected by m_asyncMutex.  Tickets below
+	 * 'm_readyTickets' have results, below 'm_completedTickets' have also been
+	 * delivered to the completion callback.
+	 */
+	int64_t						m_nextTicket = 0;
+	int64_t						m_readyTickets = 0;
+	int64_t						m_completedTickets = 0;
+	bool						m_coordinatorStarted = false;
+	bool						m_coordinatorShutdown = false;
+	pthread_t					m_coordinatorTid;
+	pthread_mutex_t				m_asyncMutex = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t				m_asyncCond = PTHREAD_COND_INITIALIZER;
+
+	/*
+	 * Worker synchronization, protected by m_mutex.  Each dispatch increments
+	 * 'm_workGeneration', workers decrement 'm_activeWorkers' when done.
+	 */
+	uint64_t					m_workGeneration = 0;
+	size_t						m_activeWorkers = 0;
+	bool						m_shutdown = false;
+	bool						m_threadsStarted = false;
 	pthread_mutex_t				m_mutex = PTHREAD_MUTEX_INITIALIZER;
 	pthread_cond_t				m_ctrlCond = PTHREAD_COND_INITIALIZER;
 	pthread_cond_t				m_workCond = PTHREAD_COND_INITIALIZER;
 
+	/*
+	 * FFTA_DISPATCH_LOW_LATENCY synchronization, the workers and the thread
+	 * calling execute() all participate in 'm_barrier' (start and end of job)
+	 */
+	fftaDispatchMode			m_dispatchMode = FFTA_DISPATCH_CONDVAR;
+	int							m_spinCount = DEFAULT_SPIN_COUNT;
+	fftaBarrier					m_barrier;
+	int							m_callerSense = 0;
+
 private:
 	static pthread_mutex_t		sm_planMutex;
+	static std::vector<planEntry *>	sm_planCache;
+	static bool					sm_threadsInitialized;
+	static bool					sm_environmentWisdomLoaded;
+
+private:
+	static void		_load_environment_wisdom();
 };
 
 
+extern template class FFTAudioT<float>;
+extern template class FFTAudioT<double>;
+
+typedef FFTAudioT<float>	FFTAudio;
+typedef FFTAudioT<double>	FFTAudioDouble;
+
+
 #endif // FFTA__FFTW__H__
@@ -0,0 +1,436 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include	<algorithm>
+#include	<cmath>
+#include	<cstring>
+#include	<limits>
+#include	<vector>
+
+#include	<fftaudio_status.h>
+#include	<fftaudio_windows.h>
+#include	<fftaudio_gccphat.h>
+
+
+/***************************************************************
+ * FFTAudioGccPhatT Constructor
+ ***************************************************************/
+
+/*
+ * The engine runs one rectangular-windowed frame per channel, the sample rate
+ * isn't used
+ */
+template<typename T>
+FFTAudioGccPhatT<T>::FFTAudioGccPhatT(int frame_size, int channel_count, int padded_frame_size) :
+	FFTAudioT<T>(fftaWindow::Rectangle, 1, frame_size,
+				 (padded_frame_size > 0) ? padded_frame_size : 2 * frame_size, channel_count)
+{
+	/*
+	 * Cache line aligned slices keep every buffer in the plans' simd alignment
+	 */
+	this->setSliceAlignment(FFTAudioBaseT<T>::AVERAGE_ALIGNMENT);
+	this->_enable_inverse_transform();
+}
+
+
+/***************************************************************
+ * FFTAudioGccPhatT Destructor
+ ***************************************************************/
+
+template<typename T>
+FFTAudioGccPhatT<T>::~FFTAudioGccPhatT()
+{
+	// Note: the buffers are carved from the FFTAudioT arena
+}
+
+
+/***************************************************************
+ * FFTAudioGccPhatT::initialize()
+ ***************************************************************/
+
+template<typename T>
+fftaStatus
+FFTAudioGccPhatT<T>::initialize()
+{
+	const int	channels = this->getBatchCount();
+	int			lag_limit;
+	fftaStatus	ret;
+
+	if(this->m_initializeFailed) {
+		return FFTA_PREVIOUS_INITIALIZE_FAILED;
+	}
+
+	if(this->m_initialized) {
+		return FFTA_ALREADY_INITIALIZED;
+	}
+
+	if(channels < 2 || this->getFrameSize() < 2 || this->getPaddedFrameSize() < this->getFrameSize()) {
+		this->m_initializeFailed = true;
+		return FFTA_INVALID_ARGUMENT;
+	}
+
+	if(m_pairs.empty()) {
+		for(int i = 0; i < channels; ++i) {
+			for(int j = i + 1; j < channels; ++j) {
+				m_pairs.push_back(i);
+				m_pairs.push_back(j);
+			}
+		}
+	}
+
+	for(size_t i = 0; i < m_pairs.size(); ++i) {
+		if(m_pairs[i] >= channels) {
+			this->m_initializeFailed = true;
+			return FFTA_INVALID_ARGUMENT;
+		}
+	}
+
+	/*
+	 * Lags beyond half the fft size alias with negative ones, those beyond the
+	 * frame size have no overlap
+	 */
+	lag_limit = this->getPaddedFrameSize() / 2;
+	if(lag_limit > this->getFrameSize()) {
+		lag_limit = this->getFrameSize();
+	}
+
+	--lag_limit;
+
+	if(m_maxLag < 0) {
+		m_maxLag = lag_limit;
+	}
+	else if(m_maxLag > lag_limit) {
+		this->m_initializeFailed = true;
+		return FFTA_INVALID_ARGUMENT;
+	}
+
+	m_delays.assign(m_pairs.size() / 2, 0);
+	m_peaks.assign(m_pairs.size() / 2, 0);
+
+	/*
+	 * Creates the plans and threads, and allocates the buffers of
+	 * _reserve_buffers()
+	 */
+	return FFTAudioT<T>::initialize();
+}
+
+
+/***************************************************************
+ * FFTAudioGccPhatT::setPairs()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioGccPhatT<T>::setPairs(const int *pairs, int pair_count)
+{
+	if(this->m_initialized || this->m_initializeFailed) {
+		return false;
+	}
+
+	if(pairs == nullptr || pair_count < 1) {
+		return false;
+	}
+
+	for(int p = 0; p < pair_count; ++p) {
+		if(pairs[2 * p] < 0 || pairs[(2 * p) + 1] < 0 || pairs[2 * p] == pairs[(2 * p) + 1]) {
+			return false;
+		}
+	}
+
+	m_pairs.assign(pairs, pairs + (2 * pair_count));
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioGccPhatT::setMaxLag()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioGccPhatT<T>::setMaxLag(int max_lag)
+{
+	if(this->m_initialized || this->m_initializeFailed || max_lag < 0) {
+		return false;
+	}
+
+	m_maxLag = max_lag;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioGccPhatT::setRegularization()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioGccPhatT<T>::setRegularization(T epsilon)
+{
+	if(this->m_initialized || this->m_initializeFailed || !(epsilon >= 0)) {
+		return false;
+	}
+
+	m_regularization = epsilon;
+	return true;
+}
+
+
+/***************************************************************
+ * FFTAudioGccPhatT::process()
+ ***************************************************************/
+
+template<typename T>
+bool
+FFTAudioGccPhatT<T>::process(const T *const *input)
+{
+	uint64_t	start = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	FFTA_ALLOC_CHECK_SCOPE();
+
+	if(!this->m_initialized) {
+		return false;
+	}
+
+	m_processInput = input;
+
+	this->_dispatch(static_cast<typename FFTAudioT<T>::FuncJob>(&FFTAudioGccPhatT::_job_channel),
+					this->getBatchCount());
+	this->_dispatch(static_cast<typename FFTAudioT<T>::FuncJob>(&FFTAudioGccPhatT::_job_pair),
+					this->getPairCount());
+
+	m_processInput = nullptr;
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_batch(this->_stats_clock() - start);
+	}
+
+	return true;
+}
+
+
+/***************************************************************
+ ****************** Protected Member Functions *****************
+ ***************************************************************/
+
+/***************************************************************
+ * FFTAudioGccPhatT::_reserve_buffers() / _assign_buffers()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioGccPhatT<T>::_reserve_buffers(fftaArena &arena, size_t alignment, int worker_count)
+{
+	size_t		spectrum_sz;
+
+	m_spectrumStride = this->_align_slice((this->getPaddedFrameSize() / 2) + 1, 2 * sizeof(T));
+	spectrum_sz = (size_t)m_spectrumStride * 2 * sizeof(T);
+
+	m_spectraAt = arena.reserve((size_t)this->getBatchCount() * spectrum_sz, alignment);
+	m_crossSpectraAt = arena.reserve((size_t)worker_count * spectrum_sz, alignment);
+	m_correlationsAt = arena.reserve((size_t)worker_count * this->getInputStride() * sizeof(T), alignment);
+}
+
+
+template<typename T>
+void
+FFTAudioGccPhatT<T>::_assign_buffers(const fftaArena &arena)
+{
+	m_spectra = (T *)arena.at(m_spectraAt);
+	m_crossSpectra = (T *)arena.at(m_crossSpectraAt);
+	m_correlations = (T *)arena.at(m_correlationsAt);
+}
+
+
+/***************************************************************
+ * FFTAudioGccPhatT::_get_max_job_items()
+ ***************************************************************/
+
+/*
+ * Pairs outnumber channels from 4 channels on (6 pairs), more workers can
+ * share the pair stage than the transforms
+ */
+template<typename T>
+int
+FFTAudioGccPhatT<T>::_get_max_job_items() const
+{
+	return std::max(this->getBatchCount(), this->getPairCount());
+}
+
+
+/***************************************************************
+ ****************** Private Member Functions *******************
+ ***************************************************************/
+
+/***************************************************************
+ * FFTAudioGccPhatT::_job_channel()
+ ***************************************************************/
+
+/*
+ * Transforms the frame of one channel, the input slice keeps the zero padding
+ * from initialize()
+ */
+template<typename T>
+void
+FFTAudioGccPhatT<T>::_job_channel(int thread_index, int channel)
+{
+	T			*frame = &this->m_inputBuffer[(size_t)this->getInputStride() * channel];
+	uint64_t	t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+
+	::memcpy(frame, m_processInput[channel], (size_t)this->getFrameSize() * sizeof(T));
+
+	this->_forward_transform(frame, &m_spectra[2 * (size_t)m_spectrumStride * channel]);
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_stage(thread_index, FFTA_STATS_TRANSFORM, this->_stats_clock() - t0);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioGccPhatT::_job_pair()
+ ***************************************************************/
+
+/*
+ * Correlates one channel pair and searches its peak
+ */
+template<typename T>
+void
+FFTAudioGccPhatT<T>::_job_pair(int thread_index, int pair)
+{
+	const int		n = this->getPaddedFrameSize();
+	const int		bins = (n / 2) + 1;
+	const T			*a = &m_spectra[2 * (size_t)m_spectrumStride * m_pairs[2 * pair]];
+	const T			*b = &m_spectra[2 * (size_t)m_spectrumStride * m_pairs[(2 * pair) + 1]];
+	T				*cross = &m_crossSpectra[2 * (size_t)m_spectrumStride * thread_index];
+	T				*r = &m_correlations[(size_t)this->getInputStride() * thread_index];
+	uint64_t		t0 = this->_stats_enabled() ? this->_stats_clock() : 0;
+	uint64_t		t1 = 0;
+	uint64_t		t2 = 0;
+	T				re;
+	T				im;
+	T				mag;
+	T				y0;
+	T				y1;
+	T				y2;
+	T				denom;
+	T				floor = 0;
+	T				offset = 0;
+	int				best = 0;
+	int				idx;
+
+	/*
+	 * Cross spectrum, then the phase transform: only the phase is kept, the
+	 * 1 / fft size scale of the inverse transform is folded in.  Without
+	 * regularization, bins at or below the smallest normal value are silent
+	 * and zeroed rather than given an arbitrary phase.
+	 */
+	for(int k = 0; k < bins; ++k) {
+		re = (a[2 * k] * b[2 * k]) + (a[(2 * k) + 1] * b[(2 * k) + 1]);
+		im = (a[(2 * k) + 1] * b[2 * k]) - (a[2 * k] * b[(2 * k) + 1]);
+		cross[2 * k] = re;
+		cross[(2 * k) + 1] = im;
+
+		if(m_regularization > 0) {
+			mag = std::sqrt((re * re) + (im * im));
+
+			if(mag > floor) {
+				floor = mag;
+			}
+		}
+	}
+
+	floor *= m_regularization;
+
+	if(floor < std::numeric_limits<T>::min()) {
+		floor = std::numeric_limits<T>::min();
+	}
+
+	for(int k = 0; k < bins; ++k) {
+		re = cross[2 * k];
+		im = cross[(2 * k) + 1];
+		mag = std::sqrt((re * re) + (im * im));
+
+		if(m_regularization > 0) {
+			mag = (T)1.0 / ((mag + floor) * n);
+		}
+		else if(mag > floor) {
+			mag = (T)1.0 / (mag * n);
+		}
+		else {
+			mag = 0;
+		}
+
+		cross[2 * k] = re * mag;
+		cross[(2 * k) + 1] = im * mag;
+	}
+
+	if(this->_stats_enabled()) {
+		t1 = this->_stats_clock();
+	}
+
+	this->_inverse_transform(cross, r);
+
+	if(this->_stats_enabled()) {
+		t2 = this->_stats_clock();
+	}
+
+	/*
+	 * Negative lags are at the end of the circular correlation
+	 */
+	for(int lag = -m_maxLag; lag <= m_maxLag; ++lag) {
+		idx = (lag < 0) ? n + lag : lag;
+
+		if(lag == -m_maxLag || r[idx] > r[(best < 0) ? n + best : best]) {
+			best = lag;
+		}
+	}
+
+	idx = (best < 0) ? n + best : best;
+	y0 = r[(idx + n - 1) % n];
+	y1 = r[idx];
+	y2 = r[(idx + 1) % n];
+	denom = y0 - (2 * y1) + y2;
+
+	if(denom < 0) {
+		offset = (T)0.5 * (y0 - y2) / denom;
+
+		if(offset > (T)0.5) {
+			offset = (T)0.5;
+		}
+		else if(offset < (T)-0.5) {
+			offset = (T)-0.5;
+		}
+	}
+
+	m_delays[pair] = (T)best + offset;
+	m_peaks[pair] = y1;
+
+	if(this->_stats_enabled()) {
+		this->_stats_add_stage(thread_index, FFTA_STATS_TRANSFORM, t2 - t1);
+		this->_stats_add_stage(thread_index, FFTA_STATS_POST_PROCESS, (t1 - t0) + (this->_stats_clock() - t2));
+	}
+}
+
+
+/***************************************************************
+ * Explicit instantiations
+ ***************************************************************/
+
+template class FFTAudioGccPhatT<float>;
+template class FFTAudioGccPhatT<double>;
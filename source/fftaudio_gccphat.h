@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FFTA__GCCPHAT__H__
+#define FFTA__GCCPHAT__H__
+
+
+#include	<vector>
+
+#include	<fftaudio_status.h>
+#include	"fftaudio_fftw.h"
+
+
+//
+// Time delay estimation between channel pairs by generalized cross
+// correlation with phase transform weighting (GCC-PHAT), on the fftw plans,
+// buffer arena and worker threads of FFTAudioT.  Every process() call:
+//		1. transforms the frame of each channel, zero padded to
+//		   'padded_frame_size' (channels are distributed across the workers)
+//		2. for each pair (i, j), forms the cross spectrum Xi * conj(Xj)
+//		   normalized to unit magnitude (see setRegularization()), transforms
+//		   it back and searches the correlation peak within +/- the maximum
+//		   lag (pairs are distributed across the workers)
+// 'T' is the floating point type, use the FFTAudioGccPhat and
+// FFTAudioGccPhatDouble typedefs.
+//
+template<typename T>
+class FFTAudioGccPhatT : protected FFTAudioT<T>
+{
+public:
+	/*
+	 * FFTAudioGccPhatT class constructor
+	 *		frame_size - samples per channel of each process() call
+	 *		channel_count - number of channels
+	 *		padded_frame_size - fft size, 0 for 2 * 'frame_size' which keeps
+	 *			every lag free of circular wrap-around
+	 */
+	FFTAudioGccPhatT(int frame_size, int channel_count, int padded_frame_size = 0);
+
+	virtual ~FFTAudioGccPhatT();
+
+	/*
+	 * initialize()
+	 *
+	 * Initialization function, must be called and succeed prior to calling
+	 * process()
+	 *
+	 *	  Returns fftaStatus, any return value besides FFTA_SUCCESS indicates a
+	 *			failure occurred and the object becomes unuseable.
+	 */
+	virtual fftaStatus initialize();
+
+	/*
+	 * setPairs()
+	 *
+	 * Sets the channel pairs to correlate, must be called before initialize().
+	 * The default is every pair (i, j) with i < j, in order.
+	 *
+	 * pairs - 'pair_count' pairs of channel indexes, { i0, j0, i1, j1, ... }
+	 * pair_count - number of pairs
+	 *
+	 *	  Returns false if already initialized or an argument is invalid
+	 */
+	bool setPairs(const int *pairs, int pair_count);
+
+	/*
+	 * setMaxLag()
+	 *
+	 * Limits the peak search to lags of +/- 'max_lag' samples, for instance
+	 * the microphone spacing over the speed of sound.  Must be called before
+	 * initialize(), which fails if it exceeds the largest lag the fft size
+	 * resolves: min(frame_size, padded_frame_size / 2) - 1, the default.
+	 *
+	 *	  Returns false if already initialized or 'max_lag' is negative
+	 */
+	bool setMaxLag(int max_lag);
+
+	/*
+	 * setRegularization()
+	 *
+	 * Sets the regularization of the phase transform.  Must be called before
+	 * initialize().  With the default of 0, every bin of the cross spectrum
+	 * is normalized to unit magnitude however weak it is, only bins at or
+	 * below std::numeric_limits<T>::min() (exact silence) are zeroed, so
+	 * bands holding nothing but noise weigh as much as the signal.  A
+	 * positive 'epsilon' weights each bin by 1 / (|G| + 'epsilon' * max |G|)
+	 * instead, which keeps the phase transform for bins well above
+	 * 'epsilon' times the strongest and fades the weaker ones out; the
+	 * correlation peak then stays below 1.  Typical values are 1e-3 to 1e-1.
+	 *
+	 * epsilon - relative regularization, 0 for the plain phase transform
+	 *
+	 *	  Returns false if already initialized or 'epsilon' is negative
+	 */
+	bool setRegularization(T epsilon);
+
+	/*
+	 * process()
+	 *
+	 * Correlates the next frame set
+	 *
+	 * input - 'channel_count' pointers to 'frame_size' samples
+	 *
+	 *	  Returns false if not initialized
+	 */
+	bool process(const T *const *input);
+
+	/*
+	 * getDelay()
+	 *
+	 * Returns the delay of pair 'pair' from the last process() call, in
+	 * samples, refined between lags by parabolic interpolation (biased
+	 * towards the nearest lag by up to ~0.15 samples on the sharp peaks of
+	 * the phase transform).  Positive when channel i lags channel j.
+	 */
+	T getDelay(int pair) const						{ return m_delays[pair];				}
+
+	/*
+	 * getPeak()
+	 *
+	 * Returns the correlation peak of pair 'pair' from the last process()
+	 * call, near 1 for a delayed copy of the same signal down to ~0 for
+	 * uncorrelated ones (lower with setRegularization())
+	 */
+	T getPeak(int pair) const						{ return m_peaks[pair];					}
+
+	using FFTAudioT<T>::getFrameSize;
+	using FFTAudioT<T>::getPaddedFrameSize;
+
+	int getChannelCount() const						{ return this->getBatchCount();			}
+	int getPairCount() const						{ return (int)m_pairs.size() / 2;		}
+	int getMaxLag() const							{ return m_maxLag;						}
+	T getRegularization() const						{ return m_regularization;				}
+
+	/*
+	 * Worker thread, memory and statistics configuration, see FFTAudioT.
+	 */
+	using FFTAudioT<T>::setWorkerCount;
+	using FFTAudioT<T>::getWorkerCount;
+	using FFTAudioT<T>::setWorkerAffinity;
+	using FFTAudioT<T>::setWorkerNode;
+	using FFTAudioT<T>::setRealtime;
+	using FFTAudioT<T>::setDispatchMode;
+	using FFTAudioT<T>::setPlannerEffort;
+	using FFTAudioT<T>::setHugePages;
+	using FFTAudioT<T>::getHugePages;
+	using FFTAudioT<T>::setStatsEnabled;
+	using FFTAudioT<T>::getStats;
+	using FFTAudioT<T>::resetStats;
+
+protected:
+	virtual void _reserve_buffers(fftaArena &arena, size_t alignment, int worker_count);
+	virtual void _assign_buffers(const fftaArena &arena);
+	virtual int _get_max_job_items() const;
+
+private:
+	void		_job_channel(int thread_index, int channel);
+	void		_job_pair(int thread_index, int pair);
+
+private:
+	/*
+	 * Channel indexes, two per pair, and the results of each pair
+	 */
+	std::vector<int>		m_pairs;
+	std::vector<T>			m_delays;
+	std::vector<T>			m_peaks;
+	int						m_maxLag = -1;
+	T						m_regularization = 0;
+
+	/*
+	 * Spectra are 'm_spectrumStride' complex values apart: one per channel and
+	 * one cross spectrum per worker.  Each worker also has a real
+	 * 'getInputStride()' buffer for the inverse transform.
+	 */
+	int						m_spectrumStride = 0;
+	size_t					m_spectraAt = 0;
+	size_t					m_crossSpectraAt = 0;
+	size_t					m_correlationsAt = 0;
+	T						*m_spectra = nullptr;
+	T						*m_crossSpectra = nullptr;
+	T						*m_correlations = nullptr;
+
+	/*
+	 * Channel buffers of the running process() call
+	 */
+	const T *const			*m_processInput = nullptr;
+
+private:
+	FFTAudioGccPhatT(const FFTAudioGccPhatT &) = delete;
+	FFTAudioGccPhatT &operator=(const FFTAudioGccPhatT &) = delete;
+};
+
+
+extern template class FFTAudioGccPhatT<float>;
+extern template class FFTAudioGccPhatT<double>;
+
+typedef FFTAudioGccPhatT<float>		FFTAudioGccPhat;
+typedef FFTAudioGccPhatT<double>	FFTAudioGccPhatDouble;
+
+
+#endif // FFTA__GCCPHAT__H__
@@ -0,0 +1,1088 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include	<cfloat>
+#include	<cstdint>
+#include	<math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define	FFTA_SIMD_X86
+	#include	<immintrin.h>
+#endif
+
+#include	<fftaudio_simd.h>
+
+
+/***************************************************************
+ * Scalar kernels
+ ***************************************************************/
+
+static void
+_magnitude_scalar(const float *complex_in, float *out, int count, float scale)
+{
+	for(int i = 0; i < count; ++i) {
+		out[i] = sqrtf((complex_in[2 * i] * complex_in[2 * i])
+							+ (complex_in[(2 * i) + 1] * complex_in[(2 * i) + 1])) * scale;
+	}
+}
+
+
+static float
+_weighted_power_scalar(const float *complex_in, const float *weights, int count)
+{
+	float	sum = 0.0f;
+
+	for(int i = 0; i < count; ++i) {
+		sum += weights[i] * ((complex_in[2 * i] * complex_in[2 * i])
+								+ (complex_in[(2 * i) + 1] * complex_in[(2 * i) + 1]));
+	}
+
+	return sum;
+}
+
+
+static void
+_accumulate_power_scalar(const float *complex_in, float *acc, int count, float weight)
+{
+	for(int i = 0; i < count; ++i) {
+		acc[i] += weight * ((complex_in[2 * i] * complex_in[2 * i])
+								+ (complex_in[(2 * i) + 1] * complex_in[(2 * i) + 1]));
+	}
+}
+
+
+static void
+_peak_power_scalar(const float *complex_in, float *acc, int count, float scale)
+{
+	for(int i = 0; i < count; ++i) {
+		acc[i] = fmaxf(acc[i], scale * ((complex_in[2 * i] * complex_in[2 * i])
+											+ (complex_in[(2 * i) + 1] * complex_in[(2 * i) + 1])));
+	}
+}
+
+
+static void
+_multiply_scalar(float *data, const float *factors, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] *= factors[i];
+	}
+}
+
+
+static void
+_add_scalar(float *data, const float *terms, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] += terms[i];
+	}
+}
+
+
+static void
+_affine_scalar(float *data, int count, float scale, float offset)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] = (data[i] * scale) + offset;
+	}
+}
+
+
+static void
+_clamp_scalar(float *data, int count, float low, float high)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] = fminf(fmaxf(data[i], low), high);
+	}
+}
+
+
+static void
+_log_scale_scalar(float *data, int count, float scale)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] = log10f(fmaxf(data[i], FLT_MIN)) * scale;
+	}
+}
+
+
+static void
+_element_maximum_scalar(float *data, const float *values, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		data[i] = fmaxf(data[i], values[i]);
+	}
+}
+
+
+static float
+_maximum_scalar(const float *data, int count)
+{
+	float	ret = data[0];
+
+	for(int i = 1; i < count; ++i) {
+		ret = fmaxf(ret, data[i]);
+	}
+
+	return ret;
+}
+
+
+static void
+_complex_multiply_scalar(const float *a, const float *b, float *out, int count)
+{
+	float	re;
+	float	im;
+
+	for(int i = 0; i < count; ++i) {
+		re = (a[2 * i] * b[2 * i]) - (a[(2 * i) + 1] * b[(2 * i) + 1]);
+		im = (a[2 * i] * b[(2 * i) + 1]) + (a[(2 * i) + 1] * b[2 * i]);
+		out[2 * i] = re;
+		out[(2 * i) + 1] = im;
+	}
+}
+
+
+static void
+_complex_multiply_accumulate_scalar(const float *a, const float *b, float *acc, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		acc[2 * i] += (a[2 * i] * b[2 * i]) - (a[(2 * i) + 1] * b[(2 * i) + 1]);
+		acc[(2 * i) + 1] += (a[2 * i] * b[(2 * i) + 1]) + (a[(2 * i) + 1] * b[2 * i]);
+	}
+}
+
+
+static void
+_goertzel_scalar(const float *in, int count, const double *cosines, const double *sines,
+				 float *out, int target_count)
+{
+	double	coeff;
+	double	s0;
+	double	s1;
+	double	s2;
+
+	for(int t = 0; t < target_count; ++t) {
+		coeff = 2.0 * cosines[t];
+		s1 = 0.0;
+		s2 = 0.0;
+
+		for(int i = 0; i < count; ++i) {
+			s0 = (double)in[i] + (coeff * s1) - s2;
+			s2 = s1;
+			s1 = s0;
+		}
+
+		out[2 * t] = (float)(s1 - (cosines[t] * s2));
+		out[(2 * t) + 1] = (float)(sines[t] * s2);
+	}
+}
+
+
+static void
+_convert_s16_scalar(const short *in, const float *window, float *out, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		out[i] = (float)in[i] * window[i];
+	}
+}
+
+
+static void
+_convert_s32_scalar(const int32_t *in, const float *window, float scale, float *out, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		out[i] = (float)in[i] * scale * window[i];
+	}
+}
+
+
+static void
+_convert_f32_scalar(const float *in, const float *window, float *out, int count)
+{
+	for(int i = 0; i < count; ++i) {
+		out[i] = in[i] * window[i];
+	}
+}
+
+
+#ifdef FFTA_SIMD_X86
+
+/***************************************************************
+ * SSE2 kernels
+ ***************************************************************/
+
+__attribute__((target("sse2")))
+static void
+_magnitude_sse2(const float *complex_in, float *out, int count, float scale)
+{
+	__m128	v_scale = _mm_set1_ps(scale);
+	__m128	lo, hi, re, im;
+	int		i = 0;
+
+	/*
+	 * 4 complex values per iteration, de-interleave into real/imaginary
+	 */
+	for(; i + 4 <= count; i += 4) {
+		lo = _mm_loadu_ps(&complex_in[2 * i]);
+		hi = _mm_loadu_ps(&complex_in[(2 * i) + 4]);
+		re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+		im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+		re = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+		_mm_storeu_ps(&out[i], _mm_mul_ps(_mm_sqrt_ps(re), v_scale));
+	}
+
+	_magnitude_scalar(&complex_in[2 * i], &out[i], count - i, scale);
+}
+
+
+__attribute__((target("sse2")))
+static float
+_weighted_power_sse2(const float *complex_in, const float *weights, int count)
+{
+	__m128	lo, hi, re, im;
+	__m128	acc = _mm_setzero_ps();
+	float	lanes[4];
+	int		i = 0;
+
+	for(; i + 4 <= count; i += 4) {
+		lo = _mm_loadu_ps(&complex_in[2 * i]);
+		hi = _mm_loadu_ps(&complex_in[(2 * i) + 4]);
+		re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+		im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+		re = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+		acc = _mm_add_ps(acc, _mm_mul_ps(re, _mm_loadu_ps(&weights[i])));
+	}
+
+	_mm_storeu_ps(lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+				+ _weighted_power_scalar(&complex_in[2 * i], &weights[i], count - i);
+}
+
+
+__attribute__((target("sse2")))
+static void
+_convert_s32_sse2(const int32_t *in, const float *window, float scale, float *out, int count)
+{
+	__m128	v_scale = _mm_set1_ps(scale);
+	__m128	v;
+	int		i = 0;
+
+	for(; i + 4 <= count; i += 4) {
+		v = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&in[i]));
+		v = _mm_mul_ps(_mm_mul_ps(v, v_scale), _mm_loadu_ps(&window[i]));
+		_mm_storeu_ps(&out[i], v);
+	}
+
+	_convert_s32_scalar(&in[i], &window[i], scale, &out[i], count - i);
+}
+
+
+__attribute__((target("sse2")))
+static void
+_convert_f32_sse2(const float *in, const float *window, float *out, int count)
+{
+	int		i = 0;
+
+	for(; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(&out[i], _mm_mul_ps(_mm_loadu_ps(&in[i]), _mm_loadu_ps(&window[i])));
+	}
+
+	_convert_f32_scalar(&in[i], &window[i], &out[i], count - i);
+}
+
+
+/***************************************************************
+ * SSE4.1 kernels
+ ***************************************************************/
+
+__attribute__((target("sse4.1")))
+static void
+_convert_s16_sse41(const short *in, const float *window, float *out, int count)
+{
+	__m128	v;
+	int		i = 0;
+
+	for(; i + 4 <= count; i += 4) {
+		v = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)&in[i])));
+		_mm_storeu_ps(&out[i], _mm_mul_ps(v, _mm_loadu_ps(&window[i])));
+	}
+
+	_convert_s16_scalar(&in[i], &window[i], &out[i], count - i);
+}
+
+
+/***************************************************************
+ * AVX2 kernels
+ ***************************************************************/
+
+__attribute__((target("avx2")))
+static void
+_magnitude_avx2(const float *complex_in, float *out, int count, float scale)
+{
+	__m256	v_scale = _mm256_set1_ps(scale);
+	__m256	lo, hi, sum;
+	int		i = 0;
+
+	/*
+	 * 8 complex values per iteration.  The squares are summed pairwise with
+	 * hadd, which works within 128-bit lanes, so the 64-bit quarters are
+	 * permuted back into bin order before storing.
+	 */
+	for(; i + 8 <= count; i += 8) {
+		lo = _mm256_loadu_ps(&complex_in[2 * i]);
+		hi = _mm256_loadu_ps(&complex_in[(2 * i) + 8]);
+		sum = _mm256_hadd_ps(_mm256_mul_ps(lo, lo), _mm256_mul_ps(hi, hi));
+		sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm256_storeu_ps(&out[i], _mm256_mul_ps(_mm256_sqrt_ps(sum), v_scale));
+	}
+
+	_magnitude_sse2(&complex_in[2 * i], &out[i], count - i, scale);
+}
+
+
+__attribute__((target("avx2")))
+static float
+_weighted_power_avx2(const float *complex_in, const float *weights, int count)
+{
+	__m256	lo, hi, sum;
+	__m256	acc = _mm256_setzero_ps();
+	float	lanes[8];
+	int		i = 0;
+
+	/*
+	 * Same bin ordering as _magnitude_avx2()
+	 */
+	for(; i + 8 <= count; i += 8) {
+		lo = _mm256_loadu_ps(&complex_in[2 * i]);
+		hi = _mm256_loadu_ps(&complex_in[(2 * i) + 8]);
+		sum = _mm256_hadd_ps(_mm256_mul_ps(lo, lo), _mm256_mul_ps(hi, hi));
+		sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(sum, _mm256_loadu_ps(&weights[i])));
+	}
+
+	_mm256_storeu_ps(lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7]
+				+ _weighted_power_sse2(&complex_in[2 * i], &weights[i], count - i);
+}
+
+
+/*
+ * Power of 8 complex values, same bin ordering as _magnitude_avx2()
+ */
+__attribute__((target("avx2")))
+static inline __m256
+_power_avx2(const float *complex_in)
+{
+	__m256	lo = _mm256_loadu_ps(complex_in);
+	__m256	hi = _mm256_loadu_ps(&complex_in[8]);
+	__m256	sum = _mm256_hadd_ps(_mm256_mul_ps(lo, lo), _mm256_mul_ps(hi, hi));
+
+	return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+
+__attribute__((target("avx2")))
+static void
+_accumulate_power_avx2(const float *complex_in, float *acc, int count, float weight)
+{
+	__m256	v_weight = _mm256_set1_ps(weight);
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&acc[i], _mm256_add_ps(_mm256_loadu_ps(&acc[i]),
+												_mm256_mul_ps(_power_avx2(&complex_in[2 * i]), v_weight)));
+	}
+
+	_accumulate_power_scalar(&complex_in[2 * i], &acc[i], count - i, weight);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_peak_power_avx2(const float *complex_in, float *acc, int count, float scale)
+{
+	__m256	v_scale = _mm256_set1_ps(scale);
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&acc[i], _mm256_max_ps(_mm256_loadu_ps(&acc[i]),
+												_mm256_mul_ps(_power_avx2(&complex_in[2 * i]), v_scale)));
+	}
+
+	_peak_power_scalar(&complex_in[2 * i], &acc[i], count - i, scale);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_element_maximum_avx2(float *data, const float *values, int count)
+{
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&data[i], _mm256_max_ps(_mm256_loadu_ps(&data[i]), _mm256_loadu_ps(&values[i])));
+	}
+
+	_element_maximum_scalar(&data[i], &values[i], count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_multiply_avx2(float *data, const float *factors, int count)
+{
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&data[i], _mm256_mul_ps(_mm256_loadu_ps(&data[i]), _mm256_loadu_ps(&factors[i])));
+	}
+
+	_multiply_scalar(&data[i], &factors[i], count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_add_avx2(float *data, const float *terms, int count)
+{
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&data[i], _mm256_add_ps(_mm256_loadu_ps(&data[i]), _mm256_loadu_ps(&terms[i])));
+	}
+
+	_add_scalar(&data[i], &terms[i], count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_affine_avx2(float *data, int count, float scale, float offset)
+{
+	__m256	v_scale = _mm256_set1_ps(scale);
+	__m256	v_offset = _mm256_set1_ps(offset);
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&data[i], _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&data[i]), v_scale), v_offset));
+	}
+
+	_affine_scalar(&data[i], count - i, scale, offset);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_clamp_avx2(float *data, int count, float low, float high)
+{
+	__m256	v_low = _mm256_set1_ps(low);
+	__m256	v_high = _mm256_set1_ps(high);
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&data[i], _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(&data[i]), v_low), v_high));
+	}
+
+	_clamp_scalar(&data[i], count - i, low, high);
+}
+
+
+/*
+ * Natural log of 8 positive normal floats, the frexp/polynomial approximation
+ * used by cephes logf (within a few ulp)
+ */
+__attribute__((target("avx2")))
+static inline __m256
+_log_avx2(__m256 x)
+{
+	const __m256	one = _mm256_set1_ps(1.0f);
+	__m256i			xi = _mm256_castps_si256(x);
+	__m256			e, m, mask, z, y;
+
+	/*
+	 * x = m * 2^e, m in [0.5, 1)
+	 */
+	e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(xi, 23), _mm256_set1_epi32(126)));
+	m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(xi, _mm256_set1_epi32(0x007fffff)),
+											_mm256_set1_epi32(0x3f000000)));
+
+	/*
+	 * Shift m into [sqrt(0.5), sqrt(2)) and subtract 1
+	 */
+	mask = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+	e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+	m = _mm256_add_ps(_mm256_sub_ps(m, one), _mm256_and_ps(m, mask));
+
+	z = _mm256_mul_ps(m, m);
+
+	y = _mm256_set1_ps(7.0376836292e-2f);
+	y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.1514610310e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.1676998740e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.2420140846e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.4249322787e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.6668057665e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(2.0000714765e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-2.4999993993e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(3.3333331174e-1f));
+	y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+
+	y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+	y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+
+	m = _mm256_add_ps(m, y);
+	return _mm256_add_ps(m, _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+
+__attribute__((target("avx2")))
+static void
+_log_scale_avx2(float *data, int count, float scale)
+{
+	__m256	v_min = _mm256_set1_ps(FLT_MIN);
+	__m256	v_scale = _mm256_set1_ps(scale * (float)M_LOG10E);
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&data[i], _mm256_mul_ps(_log_avx2(_mm256_max_ps(_mm256_loadu_ps(&data[i]), v_min)), v_scale));
+	}
+
+	_log_scale_scalar(&data[i], count - i, scale);
+}
+
+
+__attribute__((target("avx2")))
+static float
+_maximum_avx2(const float *data, int count)
+{
+	__m256	acc;
+	float	lanes[8];
+	float	ret;
+	int		i = 8;
+
+	if(count < 8) {
+		return _maximum_scalar(data, count);
+	}
+
+	acc = _mm256_loadu_ps(data);
+
+	for(; i + 8 <= count; i += 8) {
+		acc = _mm256_max_ps(acc, _mm256_loadu_ps(&data[i]));
+	}
+
+	_mm256_storeu_ps(lanes, acc);
+	ret = _maximum_scalar(lanes, 8);
+
+	for(; i < count; ++i) {
+		ret = fmaxf(ret, data[i]);
+	}
+
+	return ret;
+}
+
+
+/*
+ * Four complex values per iteration, addsub gives
+ *		(a.re * b.re - a.im * b.im, a.im * b.re + a.re * b.im)
+ */
+__attribute__((target("avx2")))
+static void
+_complex_multiply_avx2(const float *a, const float *b, float *out, int count)
+{
+	__m256	va, vb;
+	int		i = 0;
+
+	for(; i + 4 <= count; i += 4) {
+		va = _mm256_loadu_ps(&a[2 * i]);
+		vb = _mm256_loadu_ps(&b[2 * i]);
+		_mm256_storeu_ps(&out[2 * i],
+						 _mm256_addsub_ps(_mm256_mul_ps(va, _mm256_moveldup_ps(vb)),
+										  _mm256_mul_ps(_mm256_permute_ps(va, 0xb1), _mm256_movehdup_ps(vb))));
+	}
+
+	_complex_multiply_scalar(&a[2 * i], &b[2 * i], &out[2 * i], count - i);
+}
+
+
+/*
+ * Same products as _complex_multiply_avx2(), added to the accumulator
+ */
+__attribute__((target("avx2")))
+static void
+_complex_multiply_accumulate_avx2(const float *a, const float *b, float *acc, int count)
+{
+	__m256	va, vb;
+	int		i = 0;
+
+	for(; i + 4 <= count; i += 4) {
+		va = _mm256_loadu_ps(&a[2 * i]);
+		vb = _mm256_loadu_ps(&b[2 * i]);
+		_mm256_storeu_ps(&acc[2 * i],
+						 _mm256_add_ps(_mm256_loadu_ps(&acc[2 * i]),
+									   _mm256_addsub_ps(_mm256_mul_ps(va, _mm256_moveldup_ps(vb)),
+														_mm256_mul_ps(_mm256_permute_ps(va, 0xb1), _mm256_movehdup_ps(vb)))));
+	}
+
+	_complex_multiply_accumulate_scalar(&a[2 * i], &b[2 * i], &acc[2 * i], count - i);
+}
+
+
+/*
+ * Eight targets per pass over the input, one per lane of two double vectors
+ * (the second one is skipped when at most four targets remain).  A partial
+ * last group runs with zero coefficients in the unused lanes, whose results
+ * are discarded.
+ */
+__attribute__((target("avx2")))
+static void
+_goertzel_avx2(const float *in, int count, const double *cosines, const double *sines,
+			   float *out, int target_count)
+{
+	__m256d	x, coeff_lo, coeff_hi, s0, s1_lo, s2_lo, s1_hi, s2_hi;
+	double	coeffs[8];
+	double	lanes1[8];
+	double	lanes2[8];
+	int		n;
+
+	for(int t = 0; t < target_count; t += 8) {
+		n = (target_count - t < 8) ? target_count - t : 8;
+
+		for(int j = 0; j < 8; ++j) {
+			coeffs[j] = (j < n) ? 2.0 * cosines[t + j] : 0.0;
+		}
+
+		coeff_lo = _mm256_loadu_pd(coeffs);
+		coeff_hi = _mm256_loadu_pd(&coeffs[4]);
+		s1_lo = s2_lo = s1_hi = s2_hi = _mm256_setzero_pd();
+
+		if(n > 4) {
+			for(int i = 0; i < count; ++i) {
+				x = _mm256_set1_pd((double)in[i]);
+				s0 = _mm256_sub_pd(_mm256_add_pd(x, _mm256_mul_pd(coeff_lo, s1_lo)), s2_lo);
+				s2_lo = s1_lo;
+				s1_lo = s0;
+				s0 = _mm256_sub_pd(_mm256_add_pd(x, _mm256_mul_pd(coeff_hi, s1_hi)), s2_hi);
+				s2_hi = s1_hi;
+				s1_hi = s0;
+			}
+		}
+		else {
+			for(int i = 0; i < count; ++i) {
+				s0 = _mm256_sub_pd(_mm256_add_pd(_mm256_set1_pd((double)in[i]), _mm256_mul_pd(coeff_lo, s1_lo)), s2_lo);
+				s2_lo = s1_lo;
+				s1_lo = s0;
+			}
+		}
+
+		_mm256_storeu_pd(lanes1, s1_lo);
+		_mm256_storeu_pd(&lanes1[4], s1_hi);
+		_mm256_storeu_pd(lanes2, s2_lo);
+		_mm256_storeu_pd(&lanes2[4], s2_hi);
+
+		for(int j = 0; j < n; ++j) {
+			out[2 * (t + j)] = (float)(lanes1[j] - (cosines[t + j] * lanes2[j]));
+			out[(2 * (t + j)) + 1] = (float)(sines[t + j] * lanes2[j]);
+		}
+	}
+}
+
+
+__attribute__((target("avx2")))
+static void
+_convert_s16_avx2(const short *in, const float *window, float *out, int count)
+{
+	__m256	v;
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		v = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)&in[i])));
+		_mm256_storeu_ps(&out[i], _mm256_mul_ps(v, _mm256_loadu_ps(&window[i])));
+	}
+
+	_convert_s16_sse41(&in[i], &window[i], &out[i], count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_convert_s32_avx2(const int32_t *in, const float *window, float scale, float *out, int count)
+{
+	__m256	v_scale = _mm256_set1_ps(scale);
+	__m256	v;
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		v = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)&in[i]));
+		v = _mm256_mul_ps(_mm256_mul_ps(v, v_scale), _mm256_loadu_ps(&window[i]));
+		_mm256_storeu_ps(&out[i], v);
+	}
+
+	_convert_s32_sse2(&in[i], &window[i], scale, &out[i], count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_convert_f32_avx2(const float *in, const float *window, float *out, int count)
+{
+	int		i = 0;
+
+	for(; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&out[i], _mm256_mul_ps(_mm256_loadu_ps(&in[i]), _mm256_loadu_ps(&window[i])));
+	}
+
+	_convert_f32_sse2(&in[i], &window[i], &out[i], count - i);
+}
+
+
+/***************************************************************
+ * AVX-512 kernels
+ ***************************************************************/
+
+// gcc 12 warns about the intentionally undefined pass-through operand inside
+// its own avx512 intrinsic headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+static void
+_convert_s16_avx512(const short *in, const float *window, float *out, int count)
+{
+	__m512	v;
+	int		i = 0;
+
+	for(; i + 16 <= count; i += 16) {
+		v = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)&in[i])));
+		_mm512_storeu_ps(&out[i], _mm512_mul_ps(v, _mm512_loadu_ps(&window[i])));
+	}
+
+	_convert_s16_avx2(&in[i], &window[i], &out[i], count - i);
+}
+
+
+__attribute__((target("avx512f")))
+static void
+_convert_s32_avx512(const int32_t *in, const float *window, float scale, float *out, int count)
+{
+	__m512	v_scale = _mm512_set1_ps(scale);
+	__m512	v;
+	int		i = 0;
+
+	for(; i + 16 <= count; i += 16) {
+		v = _mm512_cvtepi32_ps(_mm512_loadu_si512((const void *)&in[i]));
+		v = _mm512_mul_ps(_mm512_mul_ps(v, v_scale), _mm512_loadu_ps(&window[i]));
+		_mm512_storeu_ps(&out[i], v);
+	}
+
+	_convert_s32_avx2(&in[i], &window[i], scale, &out[i], count - i);
+}
+
+
+__attribute__((target("avx512f")))
+static void
+_convert_f32_avx512(const float *in, const float *window, float *out, int count)
+{
+	int		i = 0;
+
+	for(; i + 16 <= count; i += 16) {
+		_mm512_storeu_ps(&out[i], _mm512_mul_ps(_mm512_loadu_ps(&in[i]), _mm512_loadu_ps(&window[i])));
+	}
+
+	_convert_f32_avx2(&in[i], &window[i], &out[i], count - i);
+}
+
+#pragma GCC diagnostic pop
+
+#endif // FFTA_SIMD_X86
+
+
+/***************************************************************
+ * Runtime kernel selection
+ ***************************************************************/
+
+/*
+ * Instruction set levels, each level implies the ones before it
+ */
+enum {
+	FFTA_ISA_SCALAR = 0,
+	FFTA_ISA_SSE2,
+	FFTA_ISA_SSE41,
+	FFTA_ISA_AVX2,
+	FFTA_ISA_AVX512
+};
+
+
+static int
+_select_isa()
+{
+#ifdef FFTA_SIMD_X86
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("avx512f")) {
+		return FFTA_ISA_AVX512;
+	}
+
+	if(__builtin_cpu_supports("avx2")) {
+		return FFTA_ISA_AVX2;
+	}
+
+	if(__builtin_cpu_supports("sse4.1")) {
+		return FFTA_ISA_SSE41;
+	}
+
+	if(__builtin_cpu_supports("sse2")) {
+		return FFTA_ISA_SSE2;
+	}
+#endif
+
+	return FFTA_ISA_SCALAR;
+}
+
+
+static const int	s_isa = _select_isa();
+
+
+fftaSimd::FuncMagnitude
+fftaSimd::_select_magnitude()
+{
+#ifdef FFTA_SIMD_X86
+	if(s_isa >= FFTA_ISA_AVX2) {
+		return _magnitude_avx2;
+	}
+
+	if(s_isa >= FFTA_ISA_SSE2) {
+		return _magnitude_sse2;
+	}
+#endif
+
+	return _magnitude_scalar;
+}
+
+
+fftaSimd::FuncWeightedPower
+fftaSimd::_select_weighted_power()
+{
+#ifdef FFTA_SIMD_X86
+	if(s_isa >= FFTA_ISA_AVX2) {
+		return _weighted_power_avx2;
+	}
+
+	if(s_isa >= FFTA_ISA_SSE2) {
+		return _weighted_power_sse2;
+	}
+#endif
+
+	return _weighted_power_scalar;
+}
+
+
+/*
+ * The spectrum and goertzel kernels only have scalar and AVX2 versions
+ */
+#ifdef FFTA_SIMD_X86
+	#define	FFTA_SELECT_AVX2(avx2_func, scalar_func)	\
+		return (s_isa >= FFTA_ISA_AVX2) ? avx2_func : scalar_func
+#else
+	#define	FFTA_SELECT_AVX2(avx2_func, scalar_func)	\
+		return scalar_func
+#endif
+
+fftaSimd::FuncAccumulatePower
+fftaSimd::_select_accumulate_power()
+{
+	FFTA_SELECT_AVX2(_accumulate_power_avx2, _accumulate_power_scalar);
+}
+
+
+fftaSimd::FuncAccumulatePower
+fftaSimd::_select_peak_power()
+{
+	FFTA_SELECT_AVX2(_peak_power_avx2, _peak_power_scalar);
+}
+
+
+fftaSimd::FuncElementwise
+fftaSimd::_select_element_maximum()
+{
+	FFTA_SELECT_AVX2(_element_maximum_avx2, _element_maximum_scalar);
+}
+
+
+fftaSimd::FuncElementwise
+fftaSimd::_select_multiply()
+{
+	FFTA_SELECT_AVX2(_multiply_avx2, _multiply_scalar);
+}
+
+
+fftaSimd::FuncElementwise
+fftaSimd::_select_add()
+{
+	FFTA_SELECT_AVX2(_add_avx2, _add_scalar);
+}
+
+
+fftaSimd::FuncAffine
+fftaSimd::_select_affine()
+{
+	FFTA_SELECT_AVX2(_affine_avx2, _affine_scalar);
+}
+
+
+fftaSimd::FuncAffine
+fftaSimd::_select_clamp()
+{
+	FFTA_SELECT_AVX2(_clamp_avx2, _clamp_scalar);
+}
+
+
+fftaSimd::FuncLogScale
+fftaSimd::_select_log_scale()
+{
+	FFTA_SELECT_AVX2(_log_scale_avx2, _log_scale_scalar);
+}
+
+
+fftaSimd::FuncMaximum
+fftaSimd::_select_maximum()
+{
+	FFTA_SELECT_AVX2(_maximum_avx2, _maximum_scalar);
+}
+
+
+fftaSimd::FuncComplexMultiply
+fftaSimd::_select_complex_multiply()
+{
+	FFTA_SELECT_AVX2(_complex_multiply_avx2, _complex_multiply_scalar);
+}
+
+
+fftaSimd::FuncComplexMultiply
+fftaSimd::_select_complex_multiply_accumulate()
+{
+	FFTA_SELECT_AVX2(_complex_multiply_accumulate_avx2, _complex_multiply_accumulate_scalar);
+}
+
+
+fftaSimd::FuncGoertzel
+fftaSimd::_select_goertzel()
+{
+	FFTA_SELECT_AVX2(_goertzel_avx2, _goertzel_scalar);
+}
+
+
+fftaSimd::FuncConvertS16
+fftaSimd::_select_convert_s16()
+{
+#ifdef FFTA_SIMD_X86
+	if(s_isa >= FFTA_ISA_AVX512) {
+		return _convert_s16_avx512;
+	}
+
+	if(s_isa >= FFTA_ISA_AVX2) {
+		return _convert_s16_avx2;
+	}
+
+	if(s_isa >= FFTA_ISA_SSE41) {
+		return _convert_s16_sse41;
+	}
+#endif
+
+	return _convert_s16_scalar;
+}
+
+
+fftaSimd::FuncConvertS32
+fftaSimd::_select_convert_s32()
+{
+#ifdef FFTA_SIMD_X86
+	if(s_isa >= FFTA_ISA_AVX512) {
+		return _convert_s32_avx512;
+	}
+
+	if(s_isa >= FFTA_ISA_AVX2) {
+		return _convert_s32_avx2;
+	}
+
+	if(s_isa >= FFTA_ISA_SSE2) {
+		return _convert_s32_sse2;
+	}
+#endif
+
+	return _convert_s32_scalar;
+}
+
+
+fftaSimd::FuncConvertF32
+fftaSimd::_select_convert_f32()
+{
+#ifdef FFTA_SIMD_X86
+	if(s_isa >= FFTA_ISA_AVX512) {
+		return _convert_f32_avx512;
+	}
+
+	if(s_isa >= FFTA_ISA_AVX2) {
+		return _convert_f32_avx2;
+	}
+
+	if(s_isa >= FFTA_ISA_SSE2) {
+		return _convert_f32_sse2;
+	}
+#endif
+
+	return _convert_f32_scalar;
+}
+
+
+fftaSimd::FuncMagnitude		fftaSimd::sm_magnitude = fftaSimd::_select_magnitude();
+fftaSimd::FuncWeightedPower	fftaSimd::sm_weightedPower = fftaSimd::_select_weighted_power();
+fftaSimd::FuncAccumulatePower	fftaSimd::sm_accumulatePower = fftaSimd::_select_accumulate_power();
+fftaSimd::FuncAccumulatePower	fftaSimd::sm_peakPower = fftaSimd::_select_peak_power();
+fftaSimd::FuncElementwise	fftaSimd::sm_elementMaximum = fftaSimd::_select_element_maximum();
+fftaSimd::FuncElementwise	fftaSimd::sm_multiply = fftaSimd::_select_multiply();
+fftaSimd::FuncElementwise	fftaSimd::sm_add = fftaSimd::_select_add();
+fftaSimd::FuncAffine		fftaSimd::sm_affine = fftaSimd::_select_affine();
+fftaSimd::FuncAffine		fftaSimd::sm_clamp = fftaSimd::_select_clamp();
+fftaSimd::FuncLogScale		fftaSimd::sm_logScale = fftaSimd::_select_log_scale();
+fftaSimd::FuncMaximum		fftaSimd::sm_maximum = fftaSimd::_select_maximum();
+fftaSimd::FuncConvertS16	fftaSimd::sm_convertS16 = fftaSimd::_select_convert_s16();
+fftaSimd::FuncConvertS32	fftaSimd::sm_convertS32 = fftaSimd::_select_convert_s32();
+fftaSimd::FuncConvertF32	fftaSimd::sm_convertF32 = fftaSimd::_select_convert_f32();
+fftaSimd::FuncComplexMultiply	fftaSimd::sm_complexMultiply = fftaSimd::_select_complex_multiply();
+fftaSimd::FuncComplexMultiply	fftaSimd::sm_complexMultiplyAccumulate = fftaSimd::_select_complex_multiply_accumulate();
+fftaSimd::FuncGoertzel		fftaSimd::sm_goertzel = fftaSimd::_select_goertzel();
+
+
+const char *
+fftaSimd::getIsaName()
+{
+	switch(s_isa) {
+	case FFTA_ISA_AVX512:
+		return "avx512f";
+
+	case FFTA_ISA_AVX2:
+		return "avx2";
+
+	case FFTA_ISA_SSE41:
+		return "sse4.1";
+
+	case FFTA_ISA_SSE2:
+		return "sse2";
+	}
+
+	return "scalar";
+}
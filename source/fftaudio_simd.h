@@ -0,0 +1,280 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FFTA__SIMD__H__
+#define FFTA__SIMD__H__
+
+
+#include	<cstdint>
+
+//
+// Vectorized kernels used internally by the FFTAudio implementations.
+//		Each kernel has a scalar fallback and, on x86, SSE, AVX2 and (where it
+//		helps) AVX-512 versions.
+//		The best available version is selected once at runtime based on the
+//		cpu features reported by the processor.
+//
+class fftaSimd
+{
+public:
+	/*
+	 * magnitude()
+	 *
+	 * Converts interleaved complex values to scaled magnitudes
+	 *		out[i] = sqrt(re^2 + im^2) * scale
+	 *
+	 *		complex_in - 'count' interleaved (real, imaginary) pairs
+	 *		out - array of 'count' output values
+	 *		count - number of complex values to convert
+	 *		scale - multiplier applied to each magnitude
+	 */
+	static void magnitude(const float *complex_in, float *out, int count, float scale)
+	{
+		(*sm_magnitude)(complex_in, out, count, scale);
+	}
+
+	/*
+	 * weightedPower()
+	 *
+	 * Returns the weighted sum of the power of interleaved complex values
+	 *		sum(weights[i] * (re^2 + im^2))
+	 *
+	 *		complex_in - 'count' interleaved (real, imaginary) pairs
+	 *		weights - array of 'count' weights
+	 *		count - number of complex values
+	 */
+	static float weightedPower(const float *complex_in, const float *weights, int count)
+	{
+		return (*sm_weightedPower)(complex_in, weights, count);
+	}
+
+	/*
+	 * accumulatePower() / peakPower()
+	 *
+	 * Accumulates the scaled power of interleaved complex values
+	 *		accumulatePower: acc[i] += weight * (re^2 + im^2)
+	 *		peakPower: acc[i] = max(acc[i], scale * (re^2 + im^2))
+	 *
+	 *		complex_in - 'count' interleaved (real, imaginary) pairs
+	 *		acc - array of 'count' accumulated values
+	 *		count - number of complex values
+	 */
+	static void accumulatePower(const float *complex_in, float *acc, int count, float weight)
+	{
+		(*sm_accumulatePower)(complex_in, acc, count, weight);
+	}
+
+	static void peakPower(const float *complex_in, float *acc, int count, float scale)
+	{
+		(*sm_peakPower)(complex_in, acc, count, scale);
+	}
+
+	/*
+	 * multiply() / add() / elementMaximum() / affine() / clamp() / logScale()
+	 *
+	 * In-place element-wise operations on 'count' values of 'data'
+	 *		multiply: data[i] *= factors[i]
+	 *		add: data[i] += terms[i]
+	 *		elementMaximum: data[i] = max(data[i], values[i])
+	 *		affine: data[i] = data[i] * scale + offset
+	 *		clamp: data[i] = min(max(data[i], low), high)
+	 *		logScale: data[i] = log10(max(data[i], FLT_MIN)) * scale
+	 */
+	static void multiply(float *data, const float *factors, int count)
+	{
+		(*sm_multiply)(data, factors, count);
+	}
+
+	static void add(float *data, const float *terms, int count)
+	{
+		(*sm_add)(data, terms, count);
+	}
+
+	static void elementMaximum(float *data, const float *values, int count)
+	{
+		(*sm_elementMaximum)(data, values, count);
+	}
+
+	static void affine(float *data, int count, float scale, float offset)
+	{
+		(*sm_affine)(data, count, scale, offset);
+	}
+
+	static void clamp(float *data, int count, float low, float high)
+	{
+		(*sm_clamp)(data, count, low, high);
+	}
+
+	static void logScale(float *data, int count, float scale)
+	{
+		(*sm_logScale)(data, count, scale);
+	}
+
+	/*
+	 * maximum()
+	 *
+	 * Returns the largest of 'count' values of 'data', 'count' must be > 0
+	 */
+	static float maximum(const float *data, int count)
+	{
+		return (*sm_maximum)(data, count);
+	}
+
+	/*
+	 * convertS16() / convertS32() / convertF32()
+	 *
+	 * Converts contiguous samples to float and applies the window
+	 *		convertS16: out[i] = in[i] * window[i]
+	 *		convertS32: out[i] = in[i] * scale * window[i]
+	 *		convertF32: out[i] = in[i] * window[i]
+	 *
+	 *		in - array of 'count' samples
+	 *		window - array of 'count' window values, any constant scale for the
+	 *			sample type may be folded in
+	 *		scale - additional multiplier (convertS32 only)
+	 *		out - array of 'count' output values
+	 *		count - number of samples
+	 */
+	static void convertS16(const short *in, const float *window, float *out, int count)
+	{
+		(*sm_convertS16)(in, window, out, count);
+	}
+
+	static void convertS32(const int32_t *in, const float *window, float scale, float *out, int count)
+	{
+		(*sm_convertS32)(in, window, scale, out, count);
+	}
+
+	static void convertF32(const float *in, const float *window, float *out, int count)
+	{
+		(*sm_convertF32)(in, window, out, count);
+	}
+
+	/*
+	 * complexMultiply()
+	 *
+	 * Multiplies interleaved complex values, 'out' may be the same array as 'a'
+	 *		out[i] = a[i] * b[i]
+	 *
+	 *		a, b - 'count' interleaved (real, imaginary) pairs
+	 *		out - array of 'count' interleaved output pairs
+	 *		count - number of complex values
+	 */
+	static void complexMultiply(const float *a, const float *b, float *out, int count)
+	{
+		(*sm_complexMultiply)(a, b, out, count);
+	}
+
+	/*
+	 * complexMultiplyAccumulate()
+	 *
+	 * Adds the products of interleaved complex values to an accumulator
+	 *		acc[i] += a[i] * b[i]
+	 *
+	 *		a, b - 'count' interleaved (real, imaginary) pairs
+	 *		acc - array of 'count' interleaved accumulated pairs
+	 *		count - number of complex values
+	 */
+	static void complexMultiplyAccumulate(const float *a, const float *b, float *acc, int count)
+	{
+		(*sm_complexMultiplyAccumulate)(a, b, acc, count);
+	}
+
+	/*
+	 * goertzel()
+	 *
+	 * Runs the Goertzel recurrence s[n] = in[n] + 2 * cos(w) * s[n - 1] - s[n - 2]
+	 * over 'count' samples for each of 'target_count' targets, the targets are
+	 * processed side by side.  The recurrence runs in double precision, its
+	 * rounding error grows with 'count' and near w = 0 or pi.
+	 *
+	 *		in - array of 'count' samples
+	 *		cosines, sines - arrays of 'target_count' cos(w) and sin(w)
+	 *		out - array of 'target_count' complex values receiving
+	 *			s[count - 1] - e^(-jw) * s[count - 2]
+	 */
+	static void goertzel(const float *in, int count, const double *cosines, const double *sines,
+						 float *out, int target_count)
+	{
+		(*sm_goertzel)(in, count, cosines, sines, out, target_count);
+	}
+
+	/*
+	 * getIsaName()
+	 *
+	 * Returns the name of the instruction set selected at runtime
+	 *		("avx512f", "avx2", "sse4.1", "sse2" or "scalar")
+	 */
+	static const char *getIsaName();
+
+private:
+	typedef void (*FuncMagnitude)(const float *, float *, int, float);
+	typedef float (*FuncWeightedPower)(const float *, const float *, int);
+	typedef void (*FuncAccumulatePower)(const float *, float *, int, float);
+	typedef void (*FuncElementwise)(float *, const float *, int);
+	typedef void (*FuncAffine)(float *, int, float, float);
+	typedef void (*FuncLogScale)(float *, int, float);
+	typedef float (*FuncMaximum)(const float *, int);
+	typedef void (*FuncConvertS16)(const short *, const float *, float *, int);
+	typedef void (*FuncConvertS32)(const int32_t *, const float *, float, float *, int);
+	typedef void (*FuncConvertF32)(const float *, const float *, float *, int);
+	typedef void (*FuncComplexMultiply)(const float *, const float *, float *, int);
+	typedef void (*FuncGoertzel)(const float *, int, const double *, const double *, float *, int);
+
+	static FuncMagnitude	_select_magnitude();
+	static FuncWeightedPower	_select_weighted_power();
+	static FuncAccumulatePower	_select_accumulate_power();
+	static FuncAccumulatePower	_select_peak_power();
+	static FuncElementwise	_select_element_maximum();
+	static FuncElementwise	_select_multiply();
+	static FuncElementwise	_select_add();
+	static FuncAffine		_select_affine();
+	static FuncAffine		_select_clamp();
+	static FuncLogScale		_select_log_scale();
+	static FuncMaximum		_select_maximum();
+	static FuncConvertS16	_select_convert_s16();
+	static FuncConvertS32	_select_convert_s32();
+	static FuncConvertF32	_select_convert_f32();
+	static FuncComplexMultiply	_select_complex_multiply();
+	static FuncComplexMultiply	_select_complex_multiply_accumulate();
+	static FuncGoertzel		_select_goertzel();
+
+	static FuncMagnitude	sm_magnitude;
+	static FuncWeightedPower	sm_weightedPower;
+	static FuncAccumulatePower	sm_accumulatePower;
+	static FuncAccumulatePower	sm_peakPower;
+	static FuncElementwise	sm_elementMaximum;
+	static FuncElementwise	sm_multiply;
+	static FuncElementwise	sm_add;
+	static FuncAffine		sm_affine;
+	static FuncAffine		sm_clamp;
+	static FuncLogScale		sm_logScale;
+	static FuncMaximum		sm_maximum;
+	static FuncConvertS16	sm_convertS16;
+	static FuncConvertS32	sm_convertS32;
+	static FuncConvertF32	sm_convertF32;
+	static FuncComplexMultiply	sm_complexMultiply;
+	static FuncComplexMultiply	sm_complexMultiplyAccumulate;
+	static FuncGoertzel		sm_goertzel;
+
+private:
+	fftaSimd() = default;
+	~fftaSimd() = default;
+};
+
+
+#endif // FFTA__SIMD__H__
@@ -0,0 +1,250 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include	<cstdlib>
+#include	<cstring>
+
+#include	<fftaudio_base.h>
+#include	<fftaudio_stream.h>
+
+
+/***************************************************************
+ * FFTAudioStreamT Constructor
+ ***************************************************************/
+
+template<typename T>
+FFTAudioStreamT<T>::FFTAudioStreamT(FFTAudioBaseT<T> &ffta, int hop_size) :
+	m_ffta(ffta)
+{
+	m_hopSize = hop_size;
+}
+
+
+/***************************************************************
+ * FFTAudioStreamT Destructor
+ ***************************************************************/
+
+template<typename T>
+FFTAudioStreamT<T>::~FFTAudioStreamT()
+{
+	if(m_framePointers != nullptr) {
+		::free(m_framePointers);
+	}
+
+	if(m_buffer != nullptr) {
+		::free(m_buffer);
+	}
+}
+
+
+/***************************************************************
+ * FFTAudioStreamT::initialize()
+ ***************************************************************/
+
+template<typename T>
+fftaStatus
+FFTAudioStreamT<T>::initialize()
+{
+	if(m_initializeFailed) {
+		return FFTA_PREVIOUS_INITIALIZE_FAILED;
+	}
+
+	if(m_initialized) {
+		return FFTA_ALREADY_INITIALIZED;
+	}
+
+	m_frameSize = m_ffta.getFrameSize();
+	m_batchCount = m_ffta.getBatchCount();
+
+	/*
+	 * The FFTAudio object must be initialized (frame size is only known to be
+	 * valid then), and the hop must be positive
+	 */
+	if(m_hopSize <= 0 || m_frameSize <= 0 || m_batchCount <= 0 || m_ffta.getPaddedFrameSize() <= 0) {
+		m_initializeFailed = true;
+		return FFTA_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Samples spanned by one batch of overlapping frames.  The buffer holds two
+	 * spans so the unconsumed tail is moved down at most once per batch.
+	 */
+	m_batchSpan = m_frameSize + ((m_batchCount - 1) * m_hopSize);
+	m_bufferSize = 2 * m_batchSpan;
+
+	m_buffer = (short *)::malloc((size_t)m_bufferSize * sizeof(short));
+	m_framePointers = (const short **)::malloc((size_t)m_batchCount * sizeof(const short *));
+
+	if(m_buffer == nullptr || m_framePointers == nullptr) {
+		m_initializeFailed = true;
+		return FFTA_ALLOC_FAILED;
+	}
+
+	for(int i = 0; i < m_batchCount; ++i) {
+		m_framePointers[i] = &m_buffer[i * m_hopSize];
+	}
+
+	m_initialized = true;
+	this->reset();
+	return FFTA_SUCCESS;
+}
+
+
+/***************************************************************
+ * FFTAudioStreamT::push()
+ ***************************************************************/
+
+template<typename T>
+int
+FFTAudioStreamT<T>::push(const short *samples, int count)
+{
+	int		executed = 0;
+	int		n;
+
+	if(!m_initialized) {
+		return -1;
+	}
+
+	while(count > 0) {
+		/*
+		 * Drop samples that fall between frames (hop larger than frame size)
+		 */
+		if(m_skipSamples > 0) {
+			n = (m_skipSamples < count) ? (int)m_skipSamples : count;
+			m_skipSamples -= n;
+			samples += n;
+			count -= n;
+			continue;
+		}
+
+		n = m_bufferSize - m_bufferFill;
+		if(n > count) {
+			n = count;
+		}
+
+		::memcpy(&m_buffer[m_bufferFill], samples, (size_t)n * sizeof(short));
+		m_bufferFill += n;
+		samples += n;
+		count -= n;
+
+		while(m_bufferFill >= m_batchSpan) {
+			this->_execute_batch(m_batchCount);
+			++executed;
+		}
+	}
+
+	return executed;
+}
+
+
+/***************************************************************
+ * FFTAudioStreamT::flush()
+ ***************************************************************/
+
+template<typename T>
+int
+FFTAudioStreamT<T>::flush()
+{
+	int		frame_count;
+	int		delivered = 0;
+
+	if(!m_initialized) {
+		return -1;
+	}
+
+	while(m_bufferFill > 0) {
+		/*
+		 * Frames that have at least one sample buffered
+		 */
+		frame_count = ((m_bufferFill - 1) / m_hopSize) + 1;
+
+		if(frame_count > m_batchCount) {
+			frame_count = m_batchCount;
+		}
+
+		::memset(&m_buffer[m_bufferFill], 0, (size_t)(m_batchSpan - m_bufferFill) * sizeof(short));
+		this->_execute_batch(frame_count);
+		delivered += frame_count;
+	}
+
+	this->reset();
+	return delivered;
+}
+
+
+/***************************************************************
+ * FFTAudioStreamT::reset()
+ ***************************************************************/
+
+template<typename T>
+void
+FFTAudioStreamT<T>::reset()
+{
+	m_bufferFill = 0;
+	m_skipSamples = 0;
+	m_frameIndex = 0;
+}
+
+
+/***************************************************************
+ ****************** Private Member Functions *******************
+ ***************************************************************/
+
+/***************************************************************
+ * FFTAudioStreamT::_execute_batch()
+ ***************************************************************/
+
+/*
+ * Executes the batch of frames at the start of the buffer, delivers the
+ * results and discards the samples no later frame needs
+ */
+template<typename T>
+void
+FFTAudioStreamT<T>::_execute_batch(int frame_count)
+{
+	int		consumed;
+
+	m_ffta.execute(m_framePointers);
+
+	if(m_outputCallback != nullptr) {
+		(*m_outputCallback)(*this, frame_count, m_outputCallbackUserPointer);
+	}
+
+	m_frameIndex += frame_count;
+
+	/*
+	 * Next batch starts 'batch_count' hops later
+	 */
+	consumed = m_batchCount * m_hopSize;
+
+	if(consumed >= m_bufferFill) {
+		m_skipSamples = consumed - m_bufferFill;
+		m_bufferFill = 0;
+		return;
+	}
+
+	m_bufferFill -= consumed;
+	::memmove(m_buffer, &m_buffer[consumed], (size_t)m_bufferFill * sizeof(short));
+}
+
+
+/***************************************************************
+ * Explicit instantiations
+ ***************************************************************/
+
+template class FFTAudioStreamT<float>;
+template class FFTAudioStreamT<double>;
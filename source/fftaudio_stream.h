@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FFTA__STREAM__H__
+#define FFTA__STREAM__H__
+
+
+#include	<cstdint>
+
+#include	<fftaudio_status.h>
+#include	"fftaudio_base.h"
+
+
+//
+// Streaming short-time fft on top of an FFTAudio object.  Sample blocks of any
+// length are pushed into an internal buffer, and overlapping frames spaced
+// 'hop_size' samples apart are executed 'batch_count' frames at a time.
+// Frames point directly into the internal buffer, so overlapping samples are
+// never copied per frame.  'T' is the floating point type of the FFTAudio
+// object, use the FFTAudioStream and FFTAudioStreamDouble typedefs.
+//
+template<typename T>
+class FFTAudioStreamT
+{
+public:
+	/*
+	 * FuncStreamCB Type
+	 *
+	 * Callback function type for delivering results.  Called after each execute()
+	 * of the underlying FFTAudio object, results are read from the object returned
+	 * by getEngine() (batch 'n' holds stream frame getFrameIndex() + 'n').
+	 *		void stream_cb(FFTAudioStreamT &stream, int frame_count, void *user_ptr)
+	 *			stream - stream that executed the batch
+	 *			frame_count - number of valid batches, 'batch_count' except
+	 *				for the final batch delivered by flush()
+	 *			user_ptr - user pointer associated with callback
+	 */
+	typedef	void (*FuncStreamCB)(FFTAudioStreamT &, int, void *);
+
+public:
+	/*
+	 * FFTAudioStreamT class constructor
+	 *		ffta - FFTAudio object used to execute frames, must outlive the stream
+	 *		hop_size - distance between the start of consecutive frames, in samples
+	 */
+	FFTAudioStreamT(FFTAudioBaseT<T> &ffta, int hop_size);
+
+	/*
+	 * FFTAudioStreamT class destructor
+	 */
+	virtual ~FFTAudioStreamT();
+
+	/*
+	 * initialize()
+	 *
+	 * Initialization function, must be called and succeed prior to calling push().
+	 * The FFTAudio object must already be initialized.
+	 *
+	 *	  Returns fftaStatus, any return value besides FFTA_SUCCESS indicates a
+	 *			failure occurred and FFTAudioStreamT object becomes unuseable.
+	 */
+	fftaStatus initialize();
+
+	/*
+	 * setOutputCallback()
+	 *
+	 * Sets the callback called after each executed batch of frames
+	 *
+	 * cb_func - 'FuncStreamCB' callback function
+	 * user_ptr - optinial user-specified pointer passed to callback function
+	 */
+	void setOutputCallback(FuncStreamCB cb_func, void *user_ptr = nullptr)
+	{
+		m_outputCallback = cb_func;
+		m_outputCallbackUserPointer = user_ptr;
+	}
+
+	/*
+	 * push()
+	 *
+	 * Appends samples to the stream, executing a batch whenever 'batch_count'
+	 * complete frames are available
+	 *
+	 * samples - sample data (signed 16-bit)
+	 * count - number of samples
+	 *
+	 *	  Returns number of batches executed, or -1 if not initialized
+	 */
+	int push(const short *samples, int count);
+
+	/*
+	 * flush()
+	 *
+	 * Executes any frames that have started but not completed, zero-padding
+	 * the missing samples, then resets the stream
+	 *
+	 *	  Returns number of frames delivered, or -1 if not initialized
+	 */
+	int flush();
+
+	/*
+	 * reset()
+	 *
+	 * Discards buffered samples and restarts frame numbering at 0
+	 */
+	void reset();
+
+	FFTAudioBaseT<T> &getEngine()					{ return m_ffta;						}
+	int getHopSize() const							{ return m_hopSize;						}
+	int64_t getFrameIndex() const					{ return m_frameIndex;					}
+
+private:
+	void		_execute_batch(int frame_count);
+
+private:
+	FFTAudioBaseT<T>		&m_ffta;
+	bool					m_initialized = false;
+	bool					m_initializeFailed = false;
+	int						m_hopSize = 0;
+	int						m_frameSize = 0;
+	int						m_batchCount = 0;
+	int						m_batchSpan = 0;
+	short					*m_buffer = nullptr;
+	int						m_bufferSize = 0;
+	int						m_bufferFill = 0;
+	int64_t					m_skipSamples = 0;
+	int64_t					m_frameIndex = 0;
+	const short				**m_framePointers = nullptr;
+	FuncStreamCB			m_outputCallback = nullptr;
+	void					*m_outputCallbackUserPointer = nullptr;
+
+private:
+	FFTAudioStreamT(const FFTAudioStreamT &) = delete;
+	FFTAudioStreamT &operator=(const FFTAudioStreamT &) = delete;
+};
+
+
+extern template class FFTAudioStreamT<float>;
+extern template class FFTAudioStreamT<double>;
+
+typedef FFTAudioStreamT<float>		FFTAudioStream;
+typedef FFTAudioStreamT<double>		FFTAudioStreamDouble;
+
+
+#endif // FFTA__STREAM__H__
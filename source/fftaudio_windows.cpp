@@ -16,158 +16,190 @@
 ///////////////////////////////////////////////////////////////////////////
 
 
-#include	<math.h>
+#include	<cmath>
 #include	<fftaudio_windows.h>
 
 
+template<typename T>
 void
-fftaWindow::Rectangle(int frame_size, float &sum_output, float *values)
+fftaWindow::Rectangle(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 1.0f;
+		values[i] = (T)1.0;
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::Triangluar(int frame_size, float &sum_output, float *values)
+fftaWindow::Triangluar(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 1.0f - ::fabsf(((float)i - N_MINUS_1_DIV_2(frame_size)) / ((float)frame_size / 2.0f));
+		values[i] = (T)1.0 - std::fabs(((T)i - N_MINUS_1_DIV_2(frame_size)) / ((T)frame_size / (T)2.0));
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::Bartlett(int frame_size, float &sum_output, float *values)
+fftaWindow::Bartlett(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 1.0f - ::fabsf(((float)i - N_MINUS_1_DIV_2(frame_size)) / N_MINUS_1_DIV_2(frame_size));
+		values[i] = (T)1.0 - std::fabs(((T)i - N_MINUS_1_DIV_2(frame_size)) / N_MINUS_1_DIV_2(frame_size));
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::Sine(int frame_size, float &sum_output, float *values)
+fftaWindow::Sine(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = ::sinf(((float)i * M_PI) / N_MINUS_1(frame_size));
+		values[i] = std::sin((T)(((T)i * M_PI) / N_MINUS_1(frame_size)));
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::Hann(int frame_size, float &sum_output, float *values)
+fftaWindow::Hann(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = ::sinf(((float)i * M_PI) / N_MINUS_1(frame_size));
+		values[i] = std::sin((T)(((T)i * M_PI) / N_MINUS_1(frame_size)));
 		values[i] *= values[i];
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::Hamming(int frame_size, float &sum_output, float *values)
+fftaWindow::Hamming(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 0.53836f;
-		values[i] -= 0.46164f * ::cosf(((float)i * 2.0f * M_PI) / N_MINUS_1(frame_size));
+		values[i] = (T)0.53836;
+		values[i] -= (T)0.46164 * std::cos((T)(((T)i * 2.0 * M_PI) / N_MINUS_1(frame_size)));
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::Welch(int frame_size, float &sum_output, float *values)
+fftaWindow::Welch(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
 		values[i] = N_MINUS_1_DIV_2(frame_size);
-		values[i] = ((float)i - values[i]) / values[i];
-		values[i] = 1.0f - (values[i] * values[i]);
+		values[i] = ((T)i - values[i]) / values[i];
+		values[i] = (T)1.0 - (values[i] * values[i]);
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::Blackman(int frame_size, float &sum_output, float *values)
+fftaWindow::Blackman(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 0.42659f;
-		values[i] -= 0.49656f * ::cosf(((float)i * 2.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] += 0.076849f * ::cosf(((float)i * 4.0f * M_PI) / N_MINUS_1(frame_size));
+		values[i] = (T)0.42659;
+		values[i] -= (T)0.49656 * std::cos((T)(((T)i * 2.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] += (T)0.076849 * std::cos((T)(((T)i * 4.0 * M_PI) / N_MINUS_1(frame_size)));
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::Nuttall(int frame_size, float &sum_output, float *values)
+fftaWindow::Nuttall(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 0.355768f;
-		values[i] -= 0.487396f * ::cosf(((float)i * 2.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] += 0.144232f * ::cosf(((float)i * 4.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] -= 0.012604f * ::cosf(((float)i * 6.0f * M_PI) / N_MINUS_1(frame_size));
+		values[i] = (T)0.355768;
+		values[i] -= (T)0.487396 * std::cos((T)(((T)i * 2.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] += (T)0.144232 * std::cos((T)(((T)i * 4.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] -= (T)0.012604 * std::cos((T)(((T)i * 6.0 * M_PI) / N_MINUS_1(frame_size)));
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::BlackmanNuttall(int frame_size, float &sum_output, float *values)
+fftaWindow::BlackmanNuttall(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 0.3635819f;
-		values[i] -= 0.4891775f * ::cosf(((float)i * 2.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] += 0.1365995f * ::cosf(((float)i * 4.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] -= 0.0106411f * ::cosf(((float)i * 6.0f * M_PI) / N_MINUS_1(frame_size));
+		values[i] = (T)0.3635819;
+		values[i] -= (T)0.4891775 * std::cos((T)(((T)i * 2.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] += (T)0.1365995 * std::cos((T)(((T)i * 4.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] -= (T)0.0106411 * std::cos((T)(((T)i * 6.0 * M_PI) / N_MINUS_1(frame_size)));
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::BlackmanHarris(int frame_size, float &sum_output, float *values)
+fftaWindow::BlackmanHarris(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 0.35875f;
-		values[i] -= 0.48829f * ::cosf(((float)i * 2.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] += 0.14128f * ::cosf(((float)i * 4.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] -= 0.01168f * ::cosf(((float)i * 6.0f * M_PI) / N_MINUS_1(frame_size));
+		values[i] = (T)0.35875;
+		values[i] -= (T)0.48829 * std::cos((T)(((T)i * 2.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] += (T)0.14128 * std::cos((T)(((T)i * 4.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] -= (T)0.01168 * std::cos((T)(((T)i * 6.0 * M_PI) / N_MINUS_1(frame_size)));
 		sum_output += values[i];
 	}
 }
 
+template<typename T>
 void
-fftaWindow::FlatTop(int frame_size, float &sum_output, float *values)
+fftaWindow::FlatTop(int frame_size, T &sum_output, T *values)
 {
-	sum_output = 0.0f;
+	sum_output = 0;
 
 	for(int i = 0; i < frame_size; ++i) {
-		values[i] = 1.0000f;
-		values[i] -= 1.930f * ::cosf(((float)i * 2.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] += 1.290f * ::cosf(((float)i * 4.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] -= 0.388f * ::cosf(((float)i * 6.0f * M_PI) / N_MINUS_1(frame_size));
-		values[i] += 0.028f * ::cosf(((float)i * 8.0f * M_PI) / N_MINUS_1(frame_size));
+		values[i] = (T)1.0000;
+		values[i] -= (T)1.930 * std::cos((T)(((T)i * 2.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] += (T)1.290 * std::cos((T)(((T)i * 4.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] -= (T)0.388 * std::cos((T)(((T)i * 6.0 * M_PI) / N_MINUS_1(frame_size)));
+		values[i] += (T)0.028 * std::cos((T)(((T)i * 8.0 * M_PI) / N_MINUS_1(frame_size)));
 		sum_output += values[i];
 	}
 }
 
+
+/*
+ * Explicit instantiations for float and double window tables
+ */
+#define FFTA_WINDOW_INSTANTIATE(name)											\
+	template void fftaWindow::name<float>(int, float &, float *);				\
+	template void fftaWindow::name<double>(int, double &, double *);
+
+FFTA_WINDOW_INSTANTIATE(Rectangle)
+FFTA_WINDOW_INSTANTIATE(Triangluar)
+FFTA_WINDOW_INSTANTIATE(Bartlett)
+FFTA_WINDOW_INSTANTIATE(Sine)
+FFTA_WINDOW_INSTANTIATE(Hann)
+FFTA_WINDOW_INSTANTIATE(Hamming)
+FFTA_WINDOW_INSTANTIATE(Welch)
+FFTA_WINDOW_INSTANTIATE(Blackman)
+FFTA_WINDOW_INSTANTIATE(Nuttall)
+FFTA_WINDOW_INSTANTIATE(BlackmanNuttall)
+FFTA_WINDOW_INSTANTIATE(BlackmanHarris)
+FFTA_WINDOW_INSTANTIATE(FlatTop)
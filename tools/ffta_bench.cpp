@@ -0,0 +1,351 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// ffta_bench - throughput and latency benchmark
+//
+// Runs execute() over a synthetic signal for every combination of the
+// requested frame sizes, padded sizes, batch counts, windows and worker
+// counts, and writes one JSON record per configuration with frames/sec,
+// ns per sample and the p50/p99/p99.9 execute() latency.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include	<algorithm>
+#include	<cmath>
+#include	<cstdio>
+#include	<cstdlib>
+#include	<cstring>
+#include	<ctime>
+#include	<string>
+#include	<strings.h>
+#include	<unistd.h>
+#include	<vector>
+
+#include	<fftaudio.h>
+#include	<fftaudio_simd.h>
+
+
+struct windowName
+{
+	const char					*name;
+	FFTAudio::FuncInitWindowCB	window;
+};
+
+static const windowName		s_windows[] = {
+	{ "rectangle", fftaWindow::Rectangle },
+	{ "triangular", fftaWindow::Triangluar },
+	{ "bartlett", fftaWindow::Bartlett },
+	{ "sine", fftaWindow::Sine },
+	{ "hann", fftaWindow::Hann },
+	{ "hamming", fftaWindow::Hamming },
+	{ "welch", fftaWindow::Welch },
+	{ "blackman", fftaWindow::Blackman },
+	{ "nuttall", fftaWindow::Nuttall },
+	{ "blackman-nuttall", fftaWindow::BlackmanNuttall },
+	{ "blackman-harris", fftaWindow::BlackmanHarris },
+	{ "flattop", fftaWindow::FlatTop }
+};
+
+
+static void
+usage(const char *prog)
+{
+	::fprintf(stderr,
+			  "usage: %s [-f frame_sizes] [-p padded_sizes] [-b batch_counts] [-w windows]\n"
+			  "          [-t worker_counts] [-r sample_rate] [-n iterations] [-B] [-o output]\n"
+			  "\n"
+			  "  -f frame_sizes    comma separated frame sizes (default 1024)\n"
+			  "  -p padded_sizes   comma separated padded frame sizes, 0 = frame size (default 0)\n"
+			  "  -b batch_counts   comma separated batch counts (default 1,16)\n"
+			  "  -w windows        comma separated window names (default hann)\n"
+			  "  -t worker_counts  comma separated worker counts, 0 = one per cpu (default 1)\n"
+			  "  -r sample_rate    sample rate of the synthetic signal (default 48000)\n"
+			  "  -n iterations     timed execute() calls per configuration (default 1000)\n"
+			  "  -B                use FFTA_PLAN_BATCHED mode\n"
+			  "  -o output         JSON output file (default stdout)\n",
+			  prog);
+}
+
+
+static bool
+parse_list(const char *arg, std::vector<int> &values, int min_value)
+{
+	const char	*p = arg;
+	char		*end;
+
+	values.clear();
+
+	while(*p != '\0') {
+		long	v = ::strtol(p, &end, 10);
+
+		if(end == p || v < min_value || (*end != ',' && *end != '\0')) {
+			return false;
+		}
+
+		values.push_back((int)v);
+		p = (*end == ',') ? end + 1 : end;
+	}
+
+	return !values.empty();
+}
+
+
+static bool
+parse_windows(const char *arg, std::vector<const windowName *> &windows)
+{
+	std::string		list(arg);
+	size_t			start = 0;
+
+	windows.clear();
+
+	while(start <= list.size()) {
+		size_t		end = list.find(',', start);
+		std::string	name = list.substr(start, (end == std::string::npos) ? std::string::npos : end - start);
+		size_t		i;
+
+		for(i = 0; i < sizeof(s_windows) / sizeof(s_windows[0]); ++i) {
+			if(::strcasecmp(name.c_str(), s_windows[i].name) == 0) {
+				windows.push_back(&s_windows[i]);
+				break;
+			}
+		}
+
+		if(i == sizeof(s_windows) / sizeof(s_windows[0])) {
+			::fprintf(stderr, "unknown window '%s'\n", name.c_str());
+			return false;
+		}
+
+		if(end == std::string::npos) {
+			break;
+		}
+
+		start = end + 1;
+	}
+
+	return !windows.empty();
+}
+
+
+static inline int64_t
+now_ns()
+{
+	struct timespec		ts;
+
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/*
+ * Returns the 'q' quantile (0..1) of sorted 'values', nearest rank
+ */
+static int64_t
+quantile(const std::vector<int64_t> &sorted, double q)
+{
+	size_t		rank = (size_t)std::ceil(q * sorted.size());
+
+	return sorted[(rank == 0) ? 0 : rank - 1];
+}
+
+
+/*
+ * Fills 'samples' with a few tones over a low level of pseudo-random noise,
+ * so every batch sees a different signal
+ */
+static void
+make_signal(std::vector<short> &samples, int sample_rate)
+{
+	uint32_t	seed = 0x12345678;
+
+	for(size_t i = 0; i < samples.size(); ++i) {
+		double	t = (double)i / sample_rate;
+		double	v = 6000.0 * std::sin(2.0 * M_PI * 440.0 * t)
+					+ 3000.0 * std::sin(2.0 * M_PI * 2500.0 * t)
+					+ 1000.0 * std::sin(2.0 * M_PI * 9100.0 * t);
+
+		seed = seed * 1664525u + 1013904223u;
+		v += (double)(int)(seed >> 22) - 512.0;
+
+		samples[i] = (short)v;
+	}
+}
+
+
+int
+main(int argc, char **argv)
+{
+	std::vector<int>				frame_sizes(1, 1024);
+	std::vector<int>				padded_sizes(1, 0);
+	std::vector<int>				batch_counts;
+	std::vector<int>				worker_counts(1, 1);
+	std::vector<const windowName *>	windows(1, &s_windows[4]);
+	fftaPlanMode					plan_mode = FFTA_PLAN_PER_BATCH;
+	const char						*output_file = nullptr;
+	FILE							*out = stdout;
+	int								sample_rate = 48000;
+	int								iterations = 1000;
+	int								opt;
+	bool							first = true;
+
+	batch_counts.push_back(1);
+	batch_counts.push_back(16);
+
+	while((opt = ::getopt(argc, argv, "f:p:b:w:t:r:n:Bo:h")) != -1) {
+		bool	ok = true;
+
+		switch(opt) {
+		case 'f':
+			ok = parse_list(optarg, frame_sizes, 1);
+			break;
+
+		case 'p':
+			ok = parse_list(optarg, padded_sizes, 0);
+			break;
+
+		case 'b':
+			ok = parse_list(optarg, batch_counts, 1);
+			break;
+
+		case 'w':
+			ok = parse_windows(optarg, windows);
+			break;
+
+		case 't':
+			ok = parse_list(optarg, worker_counts, 0);
+			break;
+
+		case 'r':
+			sample_rate = ::atoi(optarg);
+			ok = (sample_rate > 0);
+			break;
+
+		case 'n':
+			iterations = ::atoi(optarg);
+			ok = (iterations > 0);
+			break;
+
+		case 'B':
+			plan_mode = FFTA_PLAN_BATCHED;
+			break;
+
+		case 'o':
+			output_file = optarg;
+			break;
+
+		default:
+			ok = false;
+			break;
+		}
+
+		if(!ok) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(optind != argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(output_file != nullptr && (out = ::fopen(output_file, "w")) == nullptr) {
+		::fprintf(stderr, "failed to open '%s'\n", output_file);
+		return 1;
+	}
+
+	::fprintf(out, "{\n  \"isa\": \"%s\",\n  \"plan_mode\": \"%s\",\n  \"iterations\": %d,\n  \"results\": [",
+			  fftaSimd::getIsaName(), (plan_mode == FFTA_PLAN_BATCHED) ? "batched" : "per_batch", iterations);
+
+	for(size_t fi = 0; fi < frame_sizes.size(); ++fi)
+	for(size_t pi = 0; pi < padded_sizes.size(); ++pi)
+	for(size_t bi = 0; bi < batch_counts.size(); ++bi)
+	for(size_t wi = 0; wi < windows.size(); ++wi)
+	for(size_t ti = 0; ti < worker_counts.size(); ++ti) {
+		int		frame_size = frame_sizes[fi];
+		int		padded_size = padded_sizes[pi];
+		int		batch_count = batch_counts[bi];
+
+		if(padded_size != 0 && padded_size < frame_size) {
+			continue;
+		}
+
+		FFTAudio	ffta(windows[wi]->window, sample_rate, frame_size, padded_size, batch_count);
+
+		ffta.setWorkerCount(worker_counts[ti]);
+		ffta.setPlanMode(plan_mode);
+
+		fftaStatus	status = ffta.initialize();
+
+		if(status != FFTA_SUCCESS) {
+			::fprintf(stderr, "failed to initialize %d:%d x %d (status %d)\n",
+					  frame_size, padded_size, batch_count, (int)status.getStatusCode());
+			continue;
+		}
+
+		/*
+		 * A few distinct input blocks are cycled so the input isn't always cache hot
+		 */
+		const int				block_count = 4;
+		size_t					block_size = (size_t)frame_size * batch_count;
+		std::vector<short>		samples(block_size * block_count);
+		std::vector<int64_t>	latency(iterations);
+		int64_t					total_ns;
+
+		make_signal(samples, sample_rate);
+
+		for(int i = 0; i < std::min(iterations, 16); ++i) {
+			ffta.execute(&samples[block_size * (i % block_count)]);
+		}
+
+		total_ns = now_ns();
+
+		for(int i = 0; i < iterations; ++i) {
+			int64_t		t0 = now_ns();
+
+			ffta.execute(&samples[block_size * (i % block_count)]);
+			latency[i] = now_ns() - t0;
+		}
+
+		total_ns = now_ns() - total_ns;
+
+		std::sort(latency.begin(), latency.end());
+
+		double		frames = (double)iterations * batch_count;
+
+		::fprintf(out, "%s\n    {\"frame_size\": %d, \"padded_frame_size\": %d, \"batch_count\": %d, "
+				  "\"window\": \"%s\", \"workers\": %d, \"frames_per_sec\": %.1f, \"ns_per_sample\": %.3f, "
+				  "\"latency_ns\": {\"p50\": %lld, \"p99\": %lld, \"p99_9\": %lld, \"max\": %lld}}",
+				  first ? "" : ",", frame_size, ffta.getPaddedFrameSize(), batch_count,
+				  windows[wi]->name, ffta.getWorkerCount(),
+				  frames * 1e9 / (double)total_ns, (double)total_ns / (frames * frame_size),
+				  (long long)quantile(latency, 0.5), (long long)quantile(latency, 0.99),
+				  (long long)quantile(latency, 0.999), (long long)latency.back());
+		::fflush(out);
+
+		first = false;
+	}
+
+	::fprintf(out, "\n  ]\n}\n");
+
+	if(out != stdout) {
+		::fclose(out);
+	}
+
+	return 0;
+}
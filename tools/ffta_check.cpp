@@ -0,0 +1,389 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// ffta_check - numerical self-check of the derived engines
+//
+// Compares the output of FFTAudioConvolverT::process() with a direct
+// time-domain convolution of the same signal, in float and double, for
+// filters of one or several partitions whose tap counts aren't multiples of
+// the block size, with separate and in-place (output == input) buffers.
+// It also checks the delays FFTAudioGccPhatT finds between channels holding
+// the same band-limited signal with known integer and fractional delays:
+// the sign convention, negative lags, reversed pairs and the parabolic
+// refinement, with and without regularization.  Prints one line per case
+// and exits with 1 if any case fails.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include	<algorithm>
+#include	<cmath>
+#include	<cstdint>
+#include	<cstdio>
+#include	<cstdlib>
+#include	<unistd.h>
+#include	<vector>
+
+#include	<fftaudio.h>
+
+
+/*
+ * Returns a deterministic pseudo-random value in [-1, 1)
+ */
+static double
+next_random(uint32_t &seed)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return ((double)(seed >> 8) / (double)(1 << 23)) - 1.0;
+}
+
+
+/***************************************************************
+ * Convolver
+ ***************************************************************/
+
+struct convolverCase
+{
+	int			block_size;
+	int			channel_count;
+	int			tap_count;		// longest filter, the others are shorter
+	int			worker_count;
+	bool		in_place;
+};
+
+static const convolverCase	s_convolverCases[] = {
+	{ 64, 1, 1, 1, false },			// single tap
+	{ 64, 2, 37, 1, false },		// shorter than a block
+	{ 64, 2, 64, 2, true },			// exactly one partition
+	{ 64, 3, 200, 2, false },		// 4 partitions, partial last one
+	{ 100, 3, 301, 3, true },		// block size not a power of two
+	{ 128, 4, 1000, 2, true },		// 8 partitions, shorter filters per channel
+	{ 32, 2, 333, 0, false }		// many small partitions
+};
+
+
+/*
+ * Streams 'block_count' blocks through the convolver and returns the
+ * largest error against the direct convolution, relative to the largest
+ * output possible, or -1 if the convolver couldn't be used
+ */
+template<typename T>
+static double
+check_convolver(const convolverCase &c, int block_count)
+{
+	FFTAudioConvolverT<T>			conv(c.block_size, c.channel_count);
+	std::vector<std::vector<double>>	taps(c.channel_count);
+	std::vector<std::vector<double>>	signal(c.channel_count);
+	std::vector<std::vector<T>>		in(c.channel_count);
+	std::vector<std::vector<T>>		out(c.channel_count);
+	std::vector<const T *>			in_ptrs(c.channel_count);
+	std::vector<T *>				out_ptrs(c.channel_count);
+	uint32_t						seed = 0x2468ace1u + (uint32_t)c.tap_count;
+	double							error = 0;
+
+	conv.setWorkerCount(c.worker_count);
+
+	/*
+	 * Channel 0 has the longest filter, the others are shorter and decay, the
+	 * last channels share the default filter
+	 */
+	for(int ch = 0; ch < c.channel_count; ++ch) {
+		int				tap_count = (ch == 0) ? c.tap_count : std::max(1, c.tap_count - (17 * ch));
+		std::vector<T>	filter(tap_count);
+
+		taps[ch].resize(tap_count);
+
+		for(int k = 0; k < tap_count; ++k) {
+			taps[ch][k] = next_random(seed) * std::exp(-3.0 * k / tap_count);
+			filter[k] = (T)taps[ch][k];
+			taps[ch][k] = (double)filter[k];
+		}
+
+		if(ch < 2 && !conv.setFilter(ch, filter.data(), tap_count)) {
+			return -1;
+		}
+
+		if(ch == 2 && !conv.setFilter(-1, filter.data(), tap_count)) {
+			return -1;
+		}
+
+		if(ch > 2) {
+			taps[ch] = taps[2];
+		}
+	}
+
+	if(conv.initialize() != FFTA_SUCCESS) {
+		return -1;
+	}
+
+	for(int ch = 0; ch < c.channel_count; ++ch) {
+		signal[ch].resize((size_t)block_count * c.block_size);
+		in[ch].resize(c.block_size);
+		out[ch].resize(c.block_size);
+		in_ptrs[ch] = in[ch].data();
+		out_ptrs[ch] = c.in_place ? in[ch].data() : out[ch].data();
+
+		for(size_t i = 0; i < signal[ch].size(); ++i) {
+			signal[ch][i] = (double)(T)next_random(seed);
+		}
+	}
+
+	for(int b = 0; b < block_count; ++b) {
+		for(int ch = 0; ch < c.channel_count; ++ch) {
+			for(int i = 0; i < c.block_size; ++i) {
+				in[ch][i] = (T)signal[ch][((size_t)b * c.block_size) + i];
+			}
+		}
+
+		if(!conv.process(in_ptrs.data(), out_ptrs.data())) {
+			return -1;
+		}
+
+		for(int ch = 0; ch < c.channel_count; ++ch) {
+			const std::vector<double>	&h = taps[ch];
+			double						scale = 0;
+
+			for(size_t k = 0; k < h.size(); ++k) {
+				scale += std::fabs(h[k]);
+			}
+
+			for(int i = 0; i < c.block_size; ++i) {
+				size_t		n = ((size_t)b * c.block_size) + i;
+				double		want = 0;
+
+				for(size_t k = 0; k < h.size() && k <= n; ++k) {
+					want += h[k] * signal[ch][n - k];
+				}
+
+				error = std::max(error, std::fabs((double)out_ptrs[ch][i] - want) / scale);
+			}
+		}
+	}
+
+	return error;
+}
+
+
+template<typename T>
+static int
+run_convolver_checks(const char *precision, double tolerance, int block_count)
+{
+	int		failures = 0;
+
+	for(size_t i = 0; i < sizeof(s_convolverCases) / sizeof(s_convolverCases[0]); ++i) {
+		const convolverCase	&c = s_convolverCases[i];
+		double				error = check_convolver<T>(c, block_count);
+		bool				ok = (error >= 0 && error <= tolerance);
+
+		::printf("convolver %-6s block %4d channels %d taps %5d workers %d %-8s error %.3g %s\n",
+				 precision, c.block_size, c.channel_count, c.tap_count, c.worker_count,
+				 c.in_place ? "in-place" : "", error, ok ? "ok" : "FAILED");
+
+		if(!ok) {
+			++failures;
+		}
+	}
+
+	return failures;
+}
+
+
+/***************************************************************
+ * GCC-PHAT
+ ***************************************************************/
+
+struct gccPhatCase
+{
+	int			frame_size;
+	double		delays[3];		// of each channel, in samples
+	bool		reversed;		// pairs (j, i) instead of (i, j)
+	double		regularization;
+	double		tolerance;
+};
+
+/*
+ * The parabolic refinement is biased towards the nearest lag on the sharp
+ * peaks of the phase transform, by up to ~0.15 samples, while the nearest
+ * lag alone would be 0.25 to 0.5 samples off for the fractional cases
+ */
+static const gccPhatCase	s_gccPhatCases[] = {
+	{ 1024, { 0, 5, -13 }, false, 0, 0.05 },			// integer, positive and negative lags
+	{ 1024, { 0, 5, -13 }, true, 0, 0.05 },				// same pairs reversed, signs flip
+	{ 1024, { 0, 2.5, -7.25 }, false, 0, 0.2 },			// fractional, parabolic refinement
+	{ 512, { 3, -40.5, 60 }, false, 0, 0.2 },			// lags near +/- 100
+	{ 1024, { 0, 2.5, -7.25 }, false, 0.05, 0.2 }		// regularized
+};
+
+
+/*
+ * Correlates three channels holding a band-limited signal delayed by the
+ * case's fractional delays and returns the largest delay error over the
+ * pairs, or -1 if the engine couldn't be used
+ */
+template<typename T>
+static double
+check_gcc_phat(const gccPhatCase &c, int frame_count)
+{
+	const int						channels = 3;
+	const int						tones = 256;
+	FFTAudioGccPhatT<T>				gcc(c.frame_size, channels);
+	std::vector<std::vector<T>>		frames(channels, std::vector<T>(c.frame_size));
+	std::vector<const T *>			in_ptrs(channels);
+	std::vector<double>				freqs(tones);
+	std::vector<double>				phases(tones);
+	int								pairs[2 * channels];
+	uint32_t						seed = 0x13579bdfu + (uint32_t)c.frame_size;
+	double							error = 0;
+
+	for(int p = 0, i = 0; i < channels; ++i) {
+		for(int j = i + 1; j < channels; ++j, ++p) {
+			pairs[2 * p] = c.reversed ? j : i;
+			pairs[(2 * p) + 1] = c.reversed ? i : j;
+		}
+	}
+
+	if(!gcc.setPairs(pairs, channels) || !gcc.setRegularization((T)c.regularization)) {
+		return -1;
+	}
+
+	if(gcc.initialize() != FFTA_SUCCESS) {
+		return -1;
+	}
+
+	/*
+	 * Tones up to 0.45 cycles per sample, so the fractional delays are exact
+	 */
+	for(int t = 0; t < tones; ++t) {
+		freqs[t] = 0.225 * (next_random(seed) + 1.0);
+		phases[t] = M_PI * next_random(seed);
+	}
+
+	for(int f = 0; f < frame_count; ++f) {
+		for(int ch = 0; ch < channels; ++ch) {
+			for(int i = 0; i < c.frame_size; ++i) {
+				double	t = ((double)f * c.frame_size) + i - c.delays[ch];
+				double	v = 0;
+
+				for(int k = 0; k < tones; ++k) {
+					v += std::sin((2.0 * M_PI * freqs[k] * t) + phases[k]);
+				}
+
+				frames[ch][i] = (T)(v / tones);
+			}
+
+			in_ptrs[ch] = frames[ch].data();
+		}
+
+		if(!gcc.process(in_ptrs.data())) {
+			return -1;
+		}
+
+		/*
+		 * Positive delays when the first channel of the pair lags the second
+		 */
+		for(int p = 0; p < gcc.getPairCount(); ++p) {
+			double	want = c.delays[pairs[2 * p]] - c.delays[pairs[(2 * p) + 1]];
+
+			error = std::max(error, std::fabs((double)gcc.getDelay(p) - want));
+		}
+	}
+
+	return error;
+}
+
+
+template<typename T>
+static int
+run_gcc_phat_checks(const char *precision, int frame_count)
+{
+	int		failures = 0;
+
+	for(size_t i = 0; i < sizeof(s_gccPhatCases) / sizeof(s_gccPhatCases[0]); ++i) {
+		const gccPhatCase	&c = s_gccPhatCases[i];
+		double				error = check_gcc_phat<T>(c, frame_count);
+		bool				ok = (error >= 0 && error <= c.tolerance);
+
+		::printf("gcc-phat  %-6s frame %4d delays %g,%g,%g%s regularization %g error %.3g %s\n",
+				 precision, c.frame_size, c.delays[0], c.delays[1], c.delays[2],
+				 c.reversed ? " reversed" : "", c.regularization, error, ok ? "ok" : "FAILED");
+
+		if(!ok) {
+			++failures;
+		}
+	}
+
+	return failures;
+}
+
+
+static void
+usage(const char *prog)
+{
+	::fprintf(stderr,
+			  "usage: %s [-n blocks]\n"
+			  "\n"
+			  "  -n blocks   blocks streamed through each convolver case (default 24)\n",
+			  prog);
+}
+
+
+int
+main(int argc, char **argv)
+{
+	int		block_count = 24;
+	int		failures = 0;
+	int		opt;
+
+	while((opt = ::getopt(argc, argv, "n:h")) != -1) {
+		bool	ok = true;
+
+		switch(opt) {
+		case 'n':
+			block_count = ::atoi(optarg);
+			ok = (block_count > 0);
+			break;
+
+		default:
+			ok = false;
+			break;
+		}
+
+		if(!ok) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(optind != argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	failures += run_convolver_checks<float>("float", 1e-5, block_count);
+	failures += run_convolver_checks<double>("double", 1e-12, block_count);
+	failures += run_gcc_phat_checks<float>("float", 4);
+	failures += run_gcc_phat_checks<double>("double", 4);
+
+	if(failures > 0) {
+		::printf("%d check(s) FAILED\n", failures);
+		return 1;
+	}
+
+	::printf("all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// ffta_wisdom - fftw wisdom warm-up tool
+//
+// Plans every requested frame size with the selected planner effort and
+// saves the accumulated wisdom, so services can load it (loadWisdom() or the
+// FFTA_WISDOM_FILE environment variable) and plan instantly at startup.  fftw
+// keeps separate wisdom per precision, -d produces the double precision file
+// (FFTA_WISDOM_FILE_DOUBLE).
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include	<cstdio>
+#include	<cstdlib>
+#include	<cstring>
+#include	<strings.h>
+#include	<unistd.h>
+
+#include	<fftaudio.h>
+
+
+static void
+usage(const char *prog)
+{
+	::fprintf(stderr,
+			  "usage: %s [-e effort] [-b batch_count] [-B] [-t plan_threads] [-d]\n"
+			  "          [-i input_wisdom] -o output_wisdom frame_size[:padded_frame_size] ...\n"
+			  "\n"
+			  "  -e effort         estimate, measure, patient (default) or exhaustive\n"
+			  "  -b batch_count    batch count to plan for (default 1)\n"
+			  "  -B                plan for FFTA_PLAN_BATCHED mode\n"
+			  "  -t plan_threads   fftw threads of the batched plan (default 1), the\n"
+			  "                    'plan_threads' of setPlanMode() at runtime or the\n"
+			  "                    worker count it defaults to\n"
+			  "  -d                plan FFTAudioDouble (fftw_ double precision wisdom)\n"
+			  "  -i input_wisdom   wisdom file to extend\n"
+			  "  -o output_wisdom  wisdom file to write\n",
+			  prog);
+}
+
+
+static bool
+parse_effort(const char *name, fftaPlannerEffort &effort)
+{
+	if(::strcasecmp(name, "estimate") == 0) {
+		effort = FFTA_PLANNER_ESTIMATE;
+	}
+	else if(::strcasecmp(name, "measure") == 0) {
+		effort = FFTA_PLANNER_MEASURE;
+	}
+	else if(::strcasecmp(name, "patient") == 0) {
+		effort = FFTA_PLANNER_PATIENT;
+	}
+	else if(::strcasecmp(name, "exhaustive") == 0) {
+		effort = FFTA_PLANNER_EXHAUSTIVE;
+	}
+	else {
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * Plans every frame size of 'sizes' with engine type 'E' and saves the
+ * wisdom of its precision
+ */
+template<typename E>
+static int
+plan_sizes(fftaPlannerEffort effort, fftaPlanMode plan_mode, int batch_count, int plan_threads,
+		   const char *input_file, const char *output_file, char * const *sizes, int size_count)
+{
+	if(input_file != nullptr && !E::loadWisdom(input_file)) {
+		::fprintf(stderr, "failed to load wisdom from '%s'\n", input_file);
+		return 1;
+	}
+
+	for(int i = 0; i < size_count; ++i) {
+		int		frame_size = ::atoi(sizes[i]);
+		int		padded_frame_size = 0;
+		const char	*sep = ::strchr(sizes[i], ':');
+
+		if(sep != nullptr) {
+			padded_frame_size = ::atoi(sep + 1);
+		}
+
+		if(frame_size < 1) {
+			::fprintf(stderr, "invalid frame size '%s'\n", sizes[i]);
+			return 1;
+		}
+
+		/*
+		 * Creating the plans adds them to the process-wide wisdom.  fftw wisdom
+		 * is specific to the thread count, so a batched plan is only reused by
+		 * engines planning with the same number of threads.
+		 */
+		E			ffta(fftaWindow::Rectangle, 48000, frame_size, padded_frame_size, batch_count);
+
+		ffta.setWorkerCount(1);
+		ffta.setPlanMode(plan_mode, plan_threads);
+		ffta.setPlannerEffort(effort);
+
+		fftaStatus	status = ffta.initialize();
+
+		if(status != FFTA_SUCCESS) {
+			::fprintf(stderr, "failed to plan '%s' (status %d)\n", sizes[i], (int)status.getStatusCode());
+			return 1;
+		}
+
+		::printf("planned %d:%d x %d\n", ffta.getFrameSize(), ffta.getPaddedFrameSize(), batch_count);
+	}
+
+	if(!E::saveWisdom(output_file)) {
+		::fprintf(stderr, "failed to save wisdom to '%s'\n", output_file);
+		return 1;
+	}
+
+	return 0;
+}
+
+
+int
+main(int argc, char **argv)
+{
+	fftaPlannerEffort	effort = FFTA_PLANNER_PATIENT;
+	fftaPlanMode		plan_mode = FFTA_PLAN_PER_BATCH;
+	const char			*input_file = nullptr;
+	const char			*output_file = nullptr;
+	int					batch_count = 1;
+	int					plan_threads = 1;
+	bool				double_precision = false;
+	int					opt;
+
+	while((opt = ::getopt(argc, argv, "e:b:Bt:di:o:h")) != -1) {
+		switch(opt) {
+		case 'e':
+			if(!parse_effort(optarg, effort)) {
+				::fprintf(stderr, "invalid planner effort '%s'\n", optarg);
+				return 1;
+			}
+			break;
+
+		case 'b':
+			batch_count = ::atoi(optarg);
+			break;
+
+		case 'B':
+			plan_mode = FFTA_PLAN_BATCHED;
+			break;
+
+		case 't':
+			plan_threads = ::atoi(optarg);
+			break;
+
+		case 'd':
+			double_precision = true;
+			break;
+
+		case 'i':
+			input_file = optarg;
+			break;
+
+		case 'o':
+			output_file = optarg;
+			break;
+
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(output_file == nullptr || optind >= argc || batch_count < 1 || plan_threads < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(double_precision) {
+		return plan_sizes<FFTAudioDouble>(effort, plan_mode, batch_count, plan_threads,
+										  input_file, output_file, &argv[optind], argc - optind);
+	}
+
+	return plan_sizes<FFTAudio>(effort, plan_mode, batch_count, plan_threads,
+								input_file, output_file, &argv[optind], argc - optind);
+	return 0;
+}